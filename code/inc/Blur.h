@@ -3,6 +3,9 @@
 
 #include "Filter.h"
 #include "Utilities.h"
+#include <memory>
+
+class ThreadPool;
 
 /**
  * @file Blur.h
@@ -11,6 +14,23 @@
  * @details This class supports Median, Box, and Gaussian blur types. Each blur type
  * can be applied to either an Image or a Volume. The Gaussian blur method also supports
  * specifying the sigma value for the Gaussian kernel.
+ * The image Gaussian is computed in 16-bit fixed point by the Convolution engine, which also offers box and
+ * user-supplied kernels; the image Box blur keeps its exact running sums, whose cost does not grow with the kernel.
+ * For images the Gaussian can also run as a recursive filter (the Recursive gaussianMode), whose
+ * cost per pixel does not depend on sigma, for blurs too wide for the kernel.
+ * 
+ * The image filters run in parallel: Median on tiles of columns and rows, whose column histograms fit in cache, and
+ * Box and Gaussian on bands of rows, each reading a halo of kernel-radius rows (and columns) around it. Every tile
+ * computes exactly the pixels the serial filter would, so the result does not depend on the number of threads.
+ * A Blur constructed with `threads` runs on its own pool of that size; the default uses ThreadPool::shared().
+ * The image filters all work on ImageViews, reading rows at the view's stride, so a padded slice of a volume is
+ * blurred in place without being packed first.
+ * 
+ * The 3D filters can traverse the volume slice by slice or, with the Bricked layout, copy it into
+ * halo-padded bricks (see BrickedVolume) so each neighbourhood is read from one small block of memory.
+ * Both layouts give identical results. applyStreaming runs the same 3D filters out of core: it reads the
+ * volume through a rolling window of slices and emits each output slice as soon as it is complete, so
+ * neither the input nor the result has to fit in memory.
  * 
  * @note The Volume related methods are declared but not implemented.
  * 
@@ -24,18 +44,35 @@ class Blur : public Filter{
             Box,
             Gaussian
         };
+        // memory layout the 3D filters traverse: slice by slice, or halo-padded 32^3 bricks
+        enum layout{
+            SliceMajor,
+            Bricked
+        };
+        // how the 2D Gaussian is computed: convolution with the truncated kernel, or a recursive filter for large sigma
+        enum gaussianMode{
+            Kernel,
+            Recursive
+        };
+        explicit Blur(unsigned threads = 0);
         void apply(type filter, Image& image, int kernelSize);
-        void apply(type filter, Image& image, int kernelSize, float sigma);
-        void apply(type filter, Volume& volume, int kernelSize);
-        void apply(type filter, Volume& volume, int kernelSize, float sigma);
+        void apply(type filter, Image& image, int kernelSize, float sigma, gaussianMode mode = Kernel);
+        // the 2D filters on a view, e.g. a slice of a volume, filtered in place
+        void apply(type filter, ImageView& view, int kernelSize);
+        void apply(type filter, ImageView& view, int kernelSize, float sigma, gaussianMode mode = Kernel);
+        void apply(type filter, Volume& volume, int kernelSize, layout volumeLayout = SliceMajor);
+        void apply(type filter, Volume& volume, int kernelSize, float sigma, layout volumeLayout = SliceMajor);
+        // out-of-core 3D filters: read the volume once through a rolling window of slices and hand each output slice to `sink`
+        void applyStreaming(type filter, const Volume& volume, int kernelSize, const Volume::SliceSink& sink);
+        void applyStreaming(type filter, const Volume& volume, int kernelSize, float sigma, const Volume::SliceSink& sink);
     private:
-        void applyMedianBlurMultiChannel(Image& image , int kernelSize);
-        void applyBoxBlur(Image& image, int kernelSize);
-        void applyGaussianBlur(Image& image, int kernelSize, float sigma);
-        void _applyBoxBlurToChannel(Image& image, int kernelSize, int channelNum, unsigned char* result);
-        void _applyMedianBlurChannel(Image& image,int channel, int kernelSize, unsigned char* result);
-        void _applyGaussianBlurToChannel(Image& image, const std::vector<std::vector<float>>& kernel, int channel, unsigned char* result);
-        std::vector<std::vector<float>> _generateGaussianKernel(int kernelSize, float sigma);
+        std::shared_ptr<ThreadPool> pool; // null when using ThreadPool::shared()
+        ThreadPool& workers();
+        void applyMedianBlurMultiChannel(ImageView& view, int kernelSize);
+        void applyBoxBlur(ImageView& view, int kernelSize);
+        void applyGaussianBlur(ImageView& view, int kernelSize, float sigma);
+        void applyRecursiveGaussianBlur(ImageView& view, float sigma);
+        void _applyMedianBlurChannel(const ImageView& view, int channel, int kernelSize, unsigned char* result, int x0, int x1, int y0, int y1);
         
         void applyGaussianBlurToVolume(Volume& volume, int kernelSize, float sigma);
         void applyMedianBlurToVolume(Volume& volume, int kernelSize);
@@ -43,6 +80,17 @@ class Blur : public Filter{
         std::vector<double> _Gaussian3DKernel(const int&size, const float& sigma);
         unsigned char _CalculateWeightedAverage(const int& z, const int& y, const int& x, const std::vector<double>& weights, const int& size, const Volume& volume);
         unsigned char _CalculateMedianValue(const int& z, const int& y, const int& x, const int& size, const Volume& volume);
+        unsigned char _MedianOf(std::vector<unsigned char>& values);
+        void applyGaussianBlurToBricks(Volume& volume, int kernelSize, float sigma);
+        void applyMedianBlurToBricks(Volume& volume, int kernelSize);
+        template <typename RowAt>
+        unsigned char _WeightedAverageOf(RowAt rowAt, const int* lo, const int* hi, const std::vector<double>& weights, int size);
+        template <typename RowAt>
+        unsigned char _MedianOfWindow(RowAt rowAt, const int* lo, const int* hi, std::vector<unsigned char>& values);
+        template <typename VoxelFilter>
+        void _filterBricks(Volume& volume, int kernelSize, VoxelFilter filterVoxel);
+        template <typename VoxelFilter>
+        void _streamSlices(const Volume& volume, int kernelSize, const Volume::SliceSink& sink, VoxelFilter filterVoxel);
         void apply(){}
 };
 
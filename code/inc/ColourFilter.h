@@ -50,6 +50,11 @@ class ColourFilter : public Filter, public HSL, public HSV{
         void apply(cf filter, Image& image, std::string mode);
         void apply(cf filter, Image& image, double noisePercentage);
         void apply(cf filter, Image& image, int threshold);
+        // the same filters on a view, e.g. a slice of a volume, filtered in place
+        void apply(cf filter, ImageView& view);
+        void apply(cf filter, ImageView& view, std::string mode);
+        void apply(cf filter, ImageView& view, double noisePercentage);
+        void apply(cf filter, ImageView& view, int threshold);
             
 };
 
@@ -0,0 +1,77 @@
+#ifndef CONVOLUTION
+#define CONVOLUTION
+
+#include "Filter.h"
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+/**
+ * The Convolution class convolves 8-bit images with a kernel in fixed point. The weights are rounded to 16-bit
+ * integers at a power-of-two scale, with the rounding error handed to the weights that lost the most, so that they
+ * sum exactly to the rounded sum of the given weights: a kernel that sums to one leaves a flat image exactly
+ * unchanged. Pixels are multiplied by the weights in 16-bit lanes and accumulated in 32 bits with the kernels of
+ * ConvolutionKernels, and every result is rounded to nearest and clamped to 0 .. 255.
+ *
+ * A separable kernel is applied as a vertical pass over the 8-bit rows into a 16-bit intermediate row, which keeps
+ * as many fractional bits as its range allows, and a horizontal pass over that row, so it costs width + height
+ * multiplies per pixel. A general kernel is applied directly, width * height multiplies per pixel. The kernel is
+ * anchored at (width / 2, height / 2) and pixels outside the image are clamped to the edge. All channels of an
+ * interleaved image are filtered independently in the same passes.
+ *
+ * The scale is the largest up to 2^14 at which the weights fit 16 bits and no sum can overflow, so weights up to
+ * about 2 keep 14 fractional bits and larger ones fewer. Kernels with a gain above about 128 saturate the separable
+ * intermediate.
+ *
+ * Attributes:
+ *   width, height (int): The number of taps of the kernel along x and y.
+ *   separable (bool): Whether the kernel is applied as two 1D passes.
+ *
+ * Constructors:
+ *   Convolution(const std::vector<float>& weights, int width, int height):
+ *     A general width x height kernel, given row by row.
+ *   Convolution(const std::vector<float>& horizontal, const std::vector<float>& vertical):
+ *     The separable kernel vertical[j] * horizontal[i].
+ *   Both throw std::invalid_argument for an empty kernel, a size that does not match the weights or a weight too
+ *   large to represent in 16 bits.
+ *
+ * Public Methods:
+ *   static Convolution gaussian(int kernelSize, float sigma):
+ *     The separable Gaussian over offsets -kernelSize / 2 .. kernelSize / 2, normalised to sum to one.
+ *   static Convolution box(int kernelSize):
+ *     The separable mean over the same window.
+ *   void apply(Image& image), void apply(ImageView& view):
+ *     Convolve the image, or the pixels of the view, in place. Bands of rows run on ThreadPool::shared(), each
+ *     reading the halo of input rows its kernel reaches, so the result does not depend on the number of threads.
+ *     A view is read at its own row stride, so a padded slice of a volume is filtered without packing it first.
+ *   void apply(Image& image, ThreadPool& pool), void apply(ImageView& view, ThreadPool& pool):
+ *     The same on the given pool.
+ */
+class Convolution : public Filter{
+    public:
+        int width, height;
+        bool separable;
+        Convolution(const std::vector<float>& weights, int width, int height);
+        Convolution(const std::vector<float>& horizontal, const std::vector<float>& vertical);
+        static Convolution gaussian(int kernelSize, float sigma);
+        static Convolution box(int kernelSize);
+        void apply(Image& image) const;
+        void apply(Image& image, ThreadPool& pool) const;
+        void apply(ImageView& view) const;
+        void apply(ImageView& view, ThreadPool& pool) const;
+
+    private:
+        // weights at scale 2^shift, each kernel row padded with a zero to an even number of taps; a general kernel
+        // keeps all of its rows in horizontalWeights
+        std::vector<int16_t> horizontalWeights, verticalWeights;
+        int horizontalShift = 0, verticalShift = 0;
+        int intermediateBits = 0; // fractional bits kept between the separable passes
+
+        void filterRows(const ImageView& image, int first, int last, unsigned char* out) const;
+        void filterRowsSeparable(const ImageView& image, int first, int last, unsigned char* out) const;
+        void filterRows2D(const ImageView& image, int first, int last, unsigned char* out) const;
+        void apply(){}
+};
+
+#endif
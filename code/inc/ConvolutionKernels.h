@@ -0,0 +1,43 @@
+#ifndef CONVOLUTION_KERNELS
+#define CONVOLUTION_KERNELS
+
+#include "ProjectionKernels.h"
+#include <cstdint>
+
+/**
+ * The ConvolutionKernels struct holds the fixed-point row operations the Convolution engine is built from. Weights
+ * are 16-bit integers and every product is accumulated in 32 bits, so each pair of taps is one multiply-add of 16-bit
+ * lanes (pmaddwd):
+ *
+ *   columns(sum, rows, weights, taps, n):        sum[i] = weights[0] * rows[0][i] + ... + weights[taps - 1] * rows[taps - 1][i]
+ *   accumulateRow(sum, row, weights, taps, step, n): sum[i] += weights[0] * row[i] + ... + weights[taps - 1] * row[i + (taps - 1) * step]
+ *   narrowToShort(out, sum, shift, n):           out[i] = sum[i] / 2^shift, rounded to nearest and saturated to int16
+ *   narrowToByte(out, sum, shift, n):            out[i] = sum[i] / 2^shift, rounded to nearest and clamped to 0 .. 255
+ *
+ * `columns` blurs 8-bit rows down the image, `accumulateRow` runs along a 16-bit row whose neighbouring taps are `step`
+ * values apart (the channel count for interleaved pixels). `weights` must hold an even number of taps, padding with a
+ * zero weight, and for an odd `taps` rows[taps] (or row + taps * step) must still be readable.
+ *
+ * Scalar, SSE2 and AVX2 versions exist; AVX2 handles 16 pixels per multiply-add. All of them give identical results,
+ * since the arithmetic is exact integer arithmetic. The instruction sets are those of ProjectionKernels; AVX-512 falls
+ * back to AVX2.
+ *
+ * Functions:
+ *   const ConvolutionKernels& active(): The kernels used by Convolution.
+ *   Isa activeIsa(): The instruction set of the active kernels.
+ *   Isa select(Isa isa): Switches to the kernels for `isa`, or the widest supported set below it, and returns the set
+ *     actually chosen. Mostly useful for testing and benchmarking the individual versions.
+ */
+struct ConvolutionKernels{
+    using Isa = ProjectionKernels::Isa;
+    void (*columns)(int32_t* sum, const unsigned char* const* rows, const int16_t* weights, int taps, int n);
+    void (*accumulateRow)(int32_t* sum, const int16_t* row, const int16_t* weights, int taps, int step, int n);
+    void (*narrowToShort)(int16_t* out, const int32_t* sum, int shift, int n);
+    void (*narrowToByte)(unsigned char* out, const int32_t* sum, int shift, int n);
+
+    static const ConvolutionKernels& active();
+    static Isa activeIsa();
+    static Isa select(Isa isa);
+};
+
+#endif
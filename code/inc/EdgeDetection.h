@@ -42,6 +42,7 @@ class EdgeDetection : public Filter{
             RobertsCross
         };
         void apply(Image& image, type method);
+        void apply(ImageView& view, type method);
     private:
         void _EdgeDetect(Image& image, type method);
         void apply(){};
@@ -8,6 +8,7 @@
 #include <vector>
 #include "Image.h"
 #include "Volume.h"
+#include <functional>
 
 
 /**
@@ -26,6 +27,13 @@
  *   virtual ~Filter():
  *     A virtual destructor that ensures derived classes can have their destructors called
  *     correctly, allowing for proper resource cleanup when a Filter object is deleted.
+ *
+ * Protected Methods:
+ *   static void applyToView(ImageView& view, const std::function<void(Image&)>& filter):
+ *     Runs an Image filter on the pixels of a view, for the filters that only work on packed rows (ColourFilter
+ *     and EdgeDetection). A contiguous view is filtered in place with no copy; a strided one is packed into a
+ *     scratch image and written back. Blur and Convolution read views at their stride instead. A filter that reduces the image to
+ *     one channel leaves the view describing the single-channel result.
  */
 
 class Filter{
@@ -34,6 +42,9 @@ class Filter{
         virtual void apply() = 0;
         virtual ~Filter() = default;
 
+    protected:
+        static void applyToView(ImageView& view, const std::function<void(Image&)>& filter);
+
     private:
 
 };
@@ -6,6 +6,31 @@
 #include <memory>
 #include <string>
 
+/**
+ * The ImageView struct is a non-owning window onto pixels that live elsewhere, such as a slice of a Volume or the
+ * data of an Image. Row y starts at data + y * stride and holds w pixels of c interleaved channels; rows need not
+ * be adjacent, so a view can describe a padded XY slice or an XZ plane whose rows are in different slices. Views
+ * are cheap to copy and never allocate or free; the memory they point to must outlive them.
+ *
+ * Attributes:
+ *   data (unsigned char*): The first pixel of the first row.
+ *   w, h, c (int): Width, height and number of channels.
+ *   stride (size_t): The distance in bytes between the starts of consecutive rows, at least w * c.
+ *
+ * Member functions:
+ *   unsigned char* row(int y): The first byte of row y.
+ *   bool contiguous(): Whether the rows are packed back to back, i.e. the view is laid out exactly like an Image.
+ *   void save(const std::string& path): Saves the view as a PNG straight from the viewed memory.
+ */
+struct ImageView{
+    unsigned char* data = nullptr;
+    int w = 0, h = 0, c = 1;
+    size_t stride = 0;
+    unsigned char* row(int y) const { return data + y * stride; }
+    bool contiguous() const { return stride == static_cast<size_t>(w) * c; }
+    void save(const std::string& path) const;
+};
+
 /**
  * The Image class represents an image with attributes to store its dimensions and pixel data.
  * It provides functionalities to load an image from a file, save the image to a file, and handle
@@ -27,6 +52,7 @@
  *
  * Member function:
  *   void save(std::string path): Saves the image to a specified file path, inferring the format from the file extension.
+ *   ImageView view(): A view of the whole image, for the filters that take views.
  *
  * @author Prayush Udas
  */
@@ -40,6 +66,7 @@ class Image{
     Image(std::string path);
     ~Image(); 
     void save(std::string path);
+    ImageView view() { return {data, w, h, c, static_cast<size_t>(w) * c}; }
     
 };
 #endif 
\ No newline at end of file
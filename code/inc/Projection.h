@@ -3,6 +3,13 @@
 
 #include "Image.h"
 #include "Volume.h"
+#include <map>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstdint>
+
+class ThreadPool;
 
 /**
  * The Projection class provides functionality to apply various projection techniques to a Volume object.
@@ -10,17 +17,55 @@
  * Intensity Projection (AIP). These methods are used to project a 3D volume onto a 2D plane, typically
  * for visualization or analysis purposes.
  *
+ * Every projection reads the volume once, in slice order, so it can be streamed: projecting a volume opened with
+ * Volume::openStream folds each decoded slice into the running results and lets it go, holding about two slices
+ * at a time while the next slice is decoded in parallel with the reduction of the current one.
+ *
  * Enums:
  *   Proj: Defines the types of projections available.
  *     - projMIP: Represents Maximum Intensity Projection.
  *     - projMinIP: Represents Minimum Intensity Projection.
  *     - projAIP: Represents Average Intensity Projection.
+ *     - projStdDev: Represents the standard deviation of the intensities along the projection axis.
+ *     - projMedian: Represents the median intensity along the projection axis (z only).
+ *   Axis: The axis to project along.
+ *     - axisZ: Through the slices (axial), giving a w x h image. The default.
+ *     - axisY: Through the rows of each slice (coronal), giving a w x l image with one row per slice.
+ *     - axisX: Through the columns of each slice (sagittal), giving an h x l image with one row per slice.
+ *
+ * Constructors:
+ *   Projection(unsigned threads = 0):
+ *     The projections split the output image into bands of rows and reduce them in parallel. `threads` is the
+ *     number of threads to use; 0 uses the process-wide ThreadPool::shared(). Results do not depend on it.
  *
  * Public Method:
- *   void apply(Proj method, Volume& volume):
+ *   void apply(Proj method, Volume& volume, Axis axis = axisZ):
  *     Applies the specified projection method to the given volume.
  *     @param method The projection method to apply, specified as a value from the Proj enum.
  *     @param volume A reference to the Volume object on which the projection will be applied.
+ *     @param axis The axis to project along. Every axis reads the volume in memory order.
+ *
+ *   std::map<Proj, std::vector<unsigned char>> applyFused(const std::vector<Proj>& methods, const Volume& volume, Axis axis = axisZ):
+ *     Computes every requested projection in one pass over the voxels and returns one image per method.
+ *     @param methods The projection methods to compute.
+ *     @param volume The volume to project; unlike apply, the volume is left untouched.
+ *     @param axis The axis to project along.
+ *
+ *   std::vector<unsigned char> applyWithDepth(Proj method, const Volume& volume, std::vector<uint16_t>& depth):
+ *     Computes a MIP or MinIP along z and, in the same pass, the depth map: for every pixel the 0-based slice
+ *     at which its maximum (minimum) first occurs. Returns the w * h projection, identical to apply.
+ *     @param method projMIP or projMinIP.
+ *     @param volume The volume to project; it is not modified. At most 65536 slices.
+ *     @param depth Receives the w * h depth map.
+ *
+ *   std::vector<unsigned char> applyPercentile(float percentile, const Volume& volume):
+ *     Computes the given percentile of the intensities along z for every pixel, from per-pixel histograms
+ *     built in one pass over the slices. Returns the w * h image; the volume is left untouched.
+ *     @param percentile The percentile in [0, 100]; 0 is the minimum, 50 the median and 100 the maximum.
+ *     @param volume The volume to project.
+ *
+ *   static void outputSize(const Volume& volume, Axis axis, int& width, int& height):
+ *     The dimensions of the image a projection along `axis` produces.
  *
  * Private Methods:
  *   void MIP(Volume& volume):
@@ -43,11 +88,25 @@ class Projection{
         enum Proj{
             projMIP,
             projMinIP,
-            projAIP
+            projAIP,
+            projStdDev,
+            projMedian
+        };
+        enum Axis{
+            axisX,
+            axisY,
+            axisZ
         };
-        void apply(Proj method, Volume& volume);
+        explicit Projection(unsigned threads = 0);
+        void apply(Proj method, Volume& volume, Axis axis = axisZ);
+        std::map<Proj, std::vector<unsigned char>> applyFused(const std::vector<Proj>& methods, const Volume& volume, Axis axis = axisZ);
+        std::vector<unsigned char> applyWithDepth(Proj method, const Volume& volume, std::vector<uint16_t>& depth);
+        std::vector<unsigned char> applyPercentile(float percentile, const Volume& volume);
+        static void outputSize(const Volume& volume, Axis axis, int& width, int& height);
 
     private:
+        std::shared_ptr<ThreadPool> pool; // null when using ThreadPool::shared()
+        void forEachRow(const Volume& volume, Axis axis, const std::function<void(int, int, const unsigned char*)>& rowTask);
         void MIP(Volume& volume);
         void AIP(Volume& volume);
         void MinIP(Volume& volume);
@@ -0,0 +1,58 @@
+#ifndef PROJECTION_KERNELS
+#define PROJECTION_KERNELS
+
+#include <cstdint>
+
+/**
+ * The ProjectionKernels struct holds the per-row reductions the projections are built from. Each one
+ * folds a row of `w` voxels into a row of accumulators:
+ *
+ *   maxRow(out, row, w):        out[x] = max(out[x], row[x])
+ *   minRow(out, row, w):        out[x] = min(out[x], row[x])
+ *   sumRow(sum, row, w):        sum[x] += row[x]
+ *   sumSquaresRow(sum, row, w): sum[x] += row[x] * row[x]
+ *
+ * and the matching horizontal reductions, which fold a whole row into one value (used when projecting
+ * along x, where the voxels being reduced are contiguous):
+ *
+ *   maxOfRow(row, w), minOfRow(row, w), sumOfRow(row, w), sumSquaresOfRow(row, w)
+ *
+ * and the depth-tracking folds, which also record the slice z at which each running extreme was set. Only a
+ * strictly greater (smaller) voxel replaces the extreme, so the depth is the first slice reaching it:
+ *
+ *   maxRowWithDepth(out, depth, row, w, z): if row[x] > out[x] then out[x] = row[x], depth[x] = z
+ *   minRowWithDepth(out, depth, row, w, z): if row[x] < out[x] then out[x] = row[x], depth[x] = z
+ *
+ * Scalar, SSE2, AVX2 and AVX-512 versions exist; the widest one the CPU supports is chosen at runtime.
+ * All of them give identical results, since the operations are exact integer arithmetic.
+ *
+ * Functions:
+ *   const ProjectionKernels& active(): The kernels used by Projection.
+ *   Isa activeIsa(): The instruction set of the active kernels.
+ *   Isa select(Isa isa): Switches to the kernels for `isa`, or the widest supported set below it, and returns
+ *     the set actually chosen. Mostly useful for testing and benchmarking the individual versions.
+ */
+struct ProjectionKernels{
+    enum Isa{
+        Scalar,
+        SSE2,
+        AVX2,
+        AVX512
+    };
+    void (*maxRow)(unsigned char* out, const unsigned char* row, int w);
+    void (*minRow)(unsigned char* out, const unsigned char* row, int w);
+    void (*sumRow)(unsigned int* sum, const unsigned char* row, int w);
+    void (*sumSquaresRow)(uint64_t* sumSquares, const unsigned char* row, int w);
+    unsigned char (*maxOfRow)(const unsigned char* row, int w);
+    unsigned char (*minOfRow)(const unsigned char* row, int w);
+    uint64_t (*sumOfRow)(const unsigned char* row, int w);
+    uint64_t (*sumSquaresOfRow)(const unsigned char* row, int w);
+    void (*maxRowWithDepth)(unsigned char* out, uint16_t* depth, const unsigned char* row, int w, uint16_t z);
+    void (*minRowWithDepth)(unsigned char* out, uint16_t* depth, const unsigned char* row, int w, uint16_t z);
+
+    static const ProjectionKernels& active();
+    static Isa activeIsa();
+    static Isa select(Isa isa);
+};
+
+#endif
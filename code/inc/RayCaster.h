@@ -0,0 +1,74 @@
+#ifndef RAY_CASTER
+#define RAY_CASTER
+
+#include "Volume.h"
+#include "Projection.h"
+#include <vector>
+#include <memory>
+
+class ThreadPool;
+
+/**
+ * A 3x3 rotation applied to the viewing direction of a RayCaster. The identity looks down the z axis with
+ * x to the right and y down, exactly like an axis-aligned projection along z.
+ *
+ * Public Methods:
+ *   static Rotation identity():
+ *     No rotation.
+ *   static Rotation about(Projection::Axis axis, float degrees):
+ *     A rotation of `degrees` about the x, y or z axis of the volume.
+ *   Rotation operator*(const Rotation& other):
+ *     The rotation that applies `other` first and then this one.
+ */
+struct Rotation{
+    float m[3][3];
+    static Rotation identity();
+    static Rotation about(Projection::Axis axis, float degrees);
+    Rotation operator*(const Rotation& other) const;
+};
+
+/**
+ * The RayCaster class renders MIP, MinIP and AIP views of a volume from an arbitrary direction. An
+ * orthographic ray is cast through every output pixel, clipped to the volume's bounding box and sampled at
+ * a fixed step with trilinear interpolation. Voxel spacing is honoured, so anisotropic volumes keep their
+ * physical proportions.
+ *
+ * MIP rays stop as soon as a sample reaches 255 and MinIP rays as soon as one reaches 0, since no later
+ * sample can change the result. AIP is the mean of the samples along the ray, rounded. Pixels whose rays
+ * miss the volume are 0. Rows of the output are rendered in parallel; a lazily loaded volume is rendered
+ * on the calling thread, since its slices can be evicted between samples.
+ *
+ * Attributes:
+ *   width, height (int): The size of the rendered image in pixels.
+ *   step (float): The distance between samples along a ray, in voxels of the finest spacing.
+ *   pixelSize (float): The size of an output pixel in the same units; 0 fits the whole volume in the image
+ *                      from any direction.
+ *
+ * Constructors:
+ *   RayCaster(int width, int height, float step = 1.0f, unsigned threads = 0):
+ *     `threads` is the number of threads to render with; 0 uses ThreadPool::shared().
+ *
+ * Public Methods:
+ *   std::vector<unsigned char> render(Projection::Proj method, const Volume& volume, const Rotation& view):
+ *     Renders one width * height image of the volume seen through `view`.
+ *
+ *   std::vector<std::vector<unsigned char>> renderRotation(Projection::Proj method, const Volume& volume, int frames,
+ *                                                          Projection::Axis axis = Projection::axisY, const Rotation& base = Rotation::identity()):
+ *     Renders `frames` images turning the volume a full revolution about `axis`, after applying `base`.
+ */
+class RayCaster{
+    public:
+        int width, height;
+        float step;
+        float pixelSize = 0.0f;
+        RayCaster(int width, int height, float step = 1.0f, unsigned threads = 0);
+        std::vector<unsigned char> render(Projection::Proj method, const Volume& volume, const Rotation& view) const;
+        std::vector<std::vector<unsigned char>> renderRotation(Projection::Proj method, const Volume& volume, int frames,
+                                                               Projection::Axis axis = Projection::axisY,
+                                                               const Rotation& base = Rotation::identity()) const;
+
+    private:
+        std::shared_ptr<ThreadPool> pool; // null when using ThreadPool::shared()
+};
+
+#endif
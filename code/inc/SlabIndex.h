@@ -0,0 +1,72 @@
+#ifndef SLAB_INDEX
+#define SLAB_INDEX
+
+#include "Volume.h"
+#include "Projection.h"
+#include <vector>
+#include <cstdint>
+
+/**
+ * The SlabIndex class answers thick-slab projections over any range of slices [z0, z1] without walking the
+ * slab, so scrolling a slab through a volume costs about the same per frame whatever its thickness.
+ *
+ * For MIP and MinIP the slices are grouped into blocks of `blockSize`. Every slice stores the running
+ * maximum (minimum) from the start and from the end of its block, and a sparse table holds the maxima
+ * (minima) of every run of 2^k whole blocks. A slab that spans several blocks is then the combination of
+ * four precomputed images: the tail of its first block, the head of its last block, and two overlapping
+ * runs of whole blocks in between. A slab inside a single block is reduced directly from the volume,
+ * which touches at most `blockSize` slices.
+ *
+ * For AIP the per-pixel prefix sums of the slices are split in two: a 32-bit sum of all slices before each
+ * block, and for every slice a 16-bit sum from the start of its block through that slice, which cannot
+ * overflow since a block is at most 257 slices. A slab average is then two additions, one subtraction and
+ * one division per pixel and gives exactly the result of AIP on the slab.
+ *
+ * The index keeps a reference to the volume for slabs inside a single block, so the volume must outlive
+ * it. Memory use is about 2 * l images per MIP or MinIP plus the small block table, and 2 * l bytes per
+ * pixel plus 4 per block for AIP. Only MIP is indexed by default, since each method adds several times the
+ * size of the volume.
+ *
+ * Attributes:
+ *   w, h, l (int): The dimensions of the indexed volume.
+ *   blockSize (int): The number of slices per block.
+ *
+ * Constructors:
+ *   SlabIndex(const Volume& volume, const std::vector<Projection::Proj>& methods = {projMIP}, int blockSize = 16):
+ *     Builds the structures for the given methods (MIP, MinIP and AIP are supported). AIP uses blocks of
+ *     at most 257 slices whatever `blockSize` is.
+ *
+ * Public Methods:
+ *   std::vector<unsigned char> project(Projection::Proj method, int z0, int z1):
+ *     Returns the w * h projection of slices z0 to z1 (1-based and inclusive, like the slice range of
+ *     Volume). Throws std::invalid_argument for a method that was not indexed or an empty range.
+ */
+class SlabIndex{
+    public:
+        int w, h, l;
+        int blockSize;
+        SlabIndex(const Volume& volume, const std::vector<Projection::Proj>& methods = {Projection::projMIP}, int blockSize = 16);
+        std::vector<unsigned char> project(Projection::Proj method, int z0, int z1) const;
+
+    private:
+        // running extremes within each block and the block sparse table, for MIP or MinIP
+        struct ExtremumIndex {
+            bool built = false;
+            VoxelBuffer prefix;            // plane z: extremum from the start of z's block up to z
+            VoxelBuffer suffix;            // plane z: extremum from z to the end of its block
+            std::vector<VoxelBuffer> runs; // runs[k - 1] plane b: extremum of blocks b .. b + 2^k - 1
+        };
+        const Volume& volume;
+        size_t planeBytes;
+        int blocks;
+        ExtremumIndex maxima, minima;
+        int sumBlockSize;                  // slices per block of the AIP sums, small enough for 16-bit offsets
+        std::vector<uint32_t> blockSums;   // plane b: sum of slices 0 .. b * sumBlockSize - 1
+        std::vector<uint16_t> blockOffsets; // plane z: sum of slices from the start of z's block through z
+
+        void buildExtremum(ExtremumIndex& index, bool maximum);
+        void buildPrefixSums();
+        void projectExtremum(const ExtremumIndex& index, bool maximum, int first, int last, unsigned char* out) const;
+};
+
+#endif
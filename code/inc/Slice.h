@@ -11,14 +11,44 @@
 #include <iostream>
 #include <algorithm>
 #include <functional>
+#include <array>
 
 class Slice {
 public:
     // Constructor declared as public so that Slice objects can be created from outside the class
 
+    // How an oblique slice samples the voxels around each of its pixels
+    enum Sampling {
+        Nearest,
+        Trilinear
+    };
+
+    // How a curved slice passes through the points of its path
+    enum Curve {
+        Polyline,
+        Spline
+    };
+
+    // The plane whose slices become the slices of a re-oriented volume
+    enum Plane {
+        XZ,
+        YZ
+    };
+
     // Generate slice in the XZ plane
     void sliceXZ(Volume& volume, int y);
     void sliceYZ(Volume& volume, int x);
+    // Zero-copy views of an XY slice and of an XZ plane, for filtering in place
+    ImageView viewXY(Volume& volume, int z);
+    ImageView viewXZ(Volume& volume, int y);
+    // Generate a width x height slice through `point` (0-based voxel coordinates) perpendicular to `normal`
+    Image sliceOblique(const Volume& volume, const std::array<float, 3>& point, const std::array<float, 3>& normal,
+                       int width, int height, Sampling sampling = Trilinear, float pixelSize = 1.0f);
+    // Generate a slice `width` pixels wide that follows `path` (0-based voxel coordinates), one row per pixel along it
+    Image sliceCurved(const Volume& volume, const std::vector<std::array<float, 3>>& path, int width, Curve curve = Polyline,
+                      Sampling sampling = Trilinear, float pixelSize = 1.0f);
+    // Copy the volume into a new one whose slices are its XZ or YZ planes
+    Volume reorient(const Volume& volume, Plane plane);
 
 private:
     std::vector<Image> images; // Store loaded images
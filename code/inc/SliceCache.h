@@ -0,0 +1,60 @@
+#ifndef SLICE_CACHE
+#define SLICE_CACHE
+
+#include <list>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/**
+ * The SliceCache class backs a lazily loaded Volume. Slices are decoded from their PNG files the first
+ * time they are touched and kept in a least-recently-used cache whose size is bounded by a byte budget,
+ * so browsing or projecting part of a large stack never decodes (or holds) the whole of it.
+ *
+ * Decoded slices are dense: rows are `w` bytes apart. The cache always keeps at least one slice, and a
+ * pointer returned by slice() stays valid until that slice is evicted, i.e. until enough other slices
+ * have been decoded to exceed the budget. The cache is safe to use from several threads.
+ *
+ * Constructors:
+ *   SliceCache(std::vector<std::string> files, int w, int h, size_t budgetBytes):
+ *     @param files The PNG file of each slice, in z order.
+ *     @param w The width of every slice.
+ *     @param h The height of every slice.
+ *     @param budgetBytes The maximum number of bytes of decoded slices to keep.
+ *
+ * Public Methods:
+ *   unsigned char* slice(int z): Returns slice z, decoding it first if it is not cached.
+ *   size_t residentBytes(): The number of bytes of decoded slices currently held.
+ *   int decodedCount(): The number of slice decodes performed so far (cache misses).
+ *   size_t capacitySlices(): The number of slices the budget allows to be held at once (at least 1).
+ */
+class SliceCache{
+    public:
+        SliceCache(std::vector<std::string> files, int w, int h, size_t budgetBytes);
+        unsigned char* slice(int z);
+        size_t residentBytes() const;
+        int decodedCount() const;
+        size_t budget() const { return budgetBytes; }
+        size_t capacitySlices() const { return capacity; }
+
+    private:
+        struct Entry {
+            std::unique_ptr<unsigned char, void(*)(void*)> pixels;
+            std::list<int>::iterator position;
+        };
+        std::unique_ptr<unsigned char, void(*)(void*)> decode(int z);
+
+        std::vector<std::string> files;
+        int w, h;
+        size_t sliceBytes;
+        size_t budgetBytes;
+        size_t capacity;
+        int decoded = 0;
+        std::list<int> recent; // most recently used slice first
+        std::unordered_map<int, Entry> entries;
+        mutable std::mutex mutex;
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef THREAD_POOL
+#define THREAD_POOL
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+/**
+ * The ThreadPool class keeps a fixed set of worker threads alive so that parallel loops over slices,
+ * rows or tiles do not pay for thread creation on every call.
+ *
+ * Work is handed out with parallelFor, which splits an index range dynamically across the workers and
+ * the calling thread. The caller always takes part, so nested calls from inside a task cannot deadlock,
+ * and the first exception thrown by a task is rethrown in the caller once the loop has finished.
+ *
+ * Constructors:
+ *   ThreadPool(unsigned threads = 0):
+ *     Creates a pool that runs loops on `threads` threads in total (caller included).
+ *     A value of 0 uses std::thread::hardware_concurrency().
+ *
+ * Public Methods:
+ *   void parallelFor(int begin, int end, const std::function<void(int)>& task):
+ *     Calls task(i) for every i in [begin, end) and returns once all calls have completed.
+ *
+ *   unsigned size():
+ *     The number of threads, including the caller, that take part in a loop.
+ *
+ *   static ThreadPool& shared():
+ *     A process-wide pool sized to the hardware, for callers that do not manage their own.
+ */
+class ThreadPool{
+    public:
+        explicit ThreadPool(unsigned threads = 0);
+        ~ThreadPool();
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        void parallelFor(int begin, int end, const std::function<void(int)>& task);
+        unsigned size() const { return static_cast<unsigned>(workers.size()) + 1; }
+        static ThreadPool& shared();
+        static unsigned hardwareThreads();
+
+    private:
+        void workerLoop();
+        std::vector<std::thread> workers;
+        std::queue<std::function<void()>> jobs;
+        std::mutex mutex;
+        std::condition_variable wake;
+        bool stopping = false;
+};
+
+#endif
@@ -2,27 +2,76 @@
 #define VOLUME
 
 #include <iostream>
-#include <vector> 
+#include <vector>
 #include <map>
 #include <sstream>
 #include <filesystem>
 #include <iomanip>
 #include <format>
+#include <cstddef>
+#include <memory>
+#include <functional>
 #include "Image.h"
+#include "SliceCache.h"
+
+/**
+ * The VoxelBuffer class owns a single contiguous block of voxel memory aligned to a 64-byte boundary,
+ * so that every slice of a Volume lives in one allocation instead of one heap block per row.
+ * Copies are deep, mirroring the value semantics of the std::vector storage it replaces.
+ *
+ * A buffer can instead be backed by a private, copy-on-write memory mapping of a file, in which case
+ * pages are only read from disk the first time they are touched. Copies of a mapped buffer are
+ * ordinary heap buffers.
+ *
+ * Member functions:
+ *   unsigned char* data(): Pointer to the first byte of the buffer (nullptr when empty).
+ *   size_t size(): Number of bytes owned by the buffer.
+ *   void swap(VoxelBuffer& other): Exchanges the storage of two buffers without copying.
+ *   bool mapped(): Whether the buffer is a view of a memory-mapped file.
+ *   static VoxelBuffer mapFile(const std::string& filename, size_t offset, size_t bytes):
+ *     Maps `bytes` bytes of the file starting at `offset`. Throws std::runtime_error on failure.
+ */
+class VoxelBuffer{
+    public:
+        static constexpr size_t alignment = 64;
+        VoxelBuffer() = default;
+        explicit VoxelBuffer(size_t bytes);
+        VoxelBuffer(const VoxelBuffer& other);
+        VoxelBuffer(VoxelBuffer&& other) noexcept;
+        VoxelBuffer& operator=(VoxelBuffer other) noexcept;
+        ~VoxelBuffer();
+        unsigned char* data() { return ptr; }
+        const unsigned char* data() const { return ptr; }
+        size_t size() const { return bytes; }
+        void swap(VoxelBuffer& other) noexcept;
+        bool mapped() const { return mapping != nullptr; }
+        static VoxelBuffer mapFile(const std::string& filename, size_t offset, size_t bytes);
+    private:
+        unsigned char* ptr = nullptr;
+        size_t bytes = 0;
+        void* mapping = nullptr;
+        size_t mappingBytes = 0;
+};
 
 /**
  * The Volume class represents a 3D volume, typically used in medical imaging or scientific visualization,
  * where the volume is composed of a stack of 2D slices or a 3D array of data. This class provides
  * functionalities to load a volume from a file, access its data, and save manipulated or processed volumes.
  *
+ * Voxels are stored slice-major in one contiguous VoxelBuffer. Each row is padded to a multiple of
+ * 64 bytes, so the voxel at (x, y, z) lives at data[z * zStride + y * yStride + x * xStride].
+ * Coordinates used by the accessors are 0-based.
+ *
  * Attributes:
  *   path (std::string): The file path from which the volume was loaded or where it will be saved.
  *   w (int): Width of the volume, i.e., the number of pixels in each row of a slice.
  *   h (int): Height of the volume, i.e., the number of pixels in each column of a slice.
- *   c (int): Number of channels in the volume's data (e.g., 1 for grayscale, 3 for RGB).
+ *   c (int): Number of channels in the volume's data (always 1, slices are loaded as grayscale).
  *   l (int): The number of slices in the volume.
  *   sliced (bool): Indicates whether the volume has been sliced.
- *   data (std::vector<std::vector<std::vector<unsigned char>>>): The raw data of the volume stored as a 3D vector.
+ *   data (VoxelBuffer): The raw voxels of the volume stored as one contiguous aligned block.
+ *   xStride, yStride, zStride (size_t): Distance in bytes between neighbouring voxels along x, y and z.
+ *   spacing (float[3]): Physical size of a voxel along x, y and z, stored in the native volume format.
  *   slice (std::vector<unsigned char>): The processed data after applying a projection or slicing operation.
  *
  * Constructors:
@@ -33,17 +82,54 @@
  *     Loads volume data from the specified file path. The loaded data populates the attributes of the Volume object.
  *     @param path A string representing the file path of the volume to be loaded.
  *
- *   Volume(std::string path, int minIndex=-1, int maxIndex=-1):
+ *   Volume(std::string path, int minIndex=-1, int maxIndex=-1, unsigned threads=0):
  *     Loads volume data from a specified path and applies slicing based on the given indices.
+ *     A directory is read as a stack of PNG slices; a file is opened as a native volume (see save)
+ *     and memory-mapped rather than read, so only the slices that are used are ever paged in.
  *     @param path A string representing the file path of the volume.
  *     @param minIndex The starting index for slicing the volume (inclusive). Default is -1, indicating the start of the volume.
  *     @param maxIndex The ending index for slicing the volume (inclusive). Default is -1, indicating the end of the volume.
+ *     @param threads The number of threads decoding slices in parallel. Default is 0, one per hardware thread.
  *
  * Method:
  *   void save(const std::string& path):
- *     Saves the volume or processed slice to the specified file path.
+ *     Saves the volume or processed slice to the specified file path. When the path ends in ".vol" the
+ *     volume is written in the native format: a 4096-byte header (magic, version, dimensions, channels,
+ *     voxel type and spacing) followed by the raw voxels, slice-major with unpadded rows.
  *     @param path A string representing the file path where the volume or slice will be saved.
- * 
+ *
+ *   static void convert(const std::string& dirPath, const std::string& filename, int minIndex=-1, int maxIndex=-1):
+ *     Converts a directory of PNG slices into a native ".vol" file.
+ *
+ *   static SliceSink sliceWriter(const std::string& path, const Volume& like):
+ *     Returns a sink that writes slices to disk as they arrive, for filters that produce their output one
+ *     slice at a time. A path ending in ".vol" receives a native volume with the dimensions and spacing of
+ *     `like`; any other path is a directory that receives VolImage_{z}.png files, as save() writes them.
+ *
+ *   static Volume openLazy(const std::string& dirPath, size_t budgetBytes, int minIndex=-1, int maxIndex=-1):
+ *     Opens a directory of PNG slices without decoding them. Each slice is decoded the first time an
+ *     accessor touches it and kept in an LRU SliceCache bounded by `budgetBytes`. Lazy volumes are
+ *     read-only; call materialize() to load every slice into memory before modifying voxels.
+ *
+ *   static Volume openStream(const std::string& path, int minIndex=-1, int maxIndex=-1):
+ *     Opens a volume for a single pass over its slices in z order, e.g. a projection, without ever holding
+ *     all of it. A directory of PNG slices is opened lazily with a cache of two slices, so a projection can
+ *     decode the next slice while it reduces the current one; a native file is mapped as usual.
+ *
+ *   void allocate(int width, int height, int depth):
+ *     Sets the dimensions of the volume and allocates zeroed voxel storage for them.
+ *
+ *   static Volume allocated(int width, int height, int depth):
+ *     Returns a new volume with zeroed voxel storage of those dimensions, for code that builds a result
+ *     volume; unlike the default constructor it logs nothing.
+ *
+ *   unsigned char& at(int x, int y, int z):
+ *     Returns the voxel at the given 0-based coordinates.
+ *
+ *   unsigned char* row(int y, int z) / unsigned char* slicePtr(int z):
+ *     Return a pointer to the first voxel of a row or of an XY slice; voxels within a row are contiguous.
+ *     For a lazy volume the pointer stays valid until the slice is evicted from the cache.
+ *
  * @author Prayush Udas
  */
 
@@ -51,16 +137,46 @@ class Volume{
     public:
         std::string path;
         int w, h, c, l;
-        bool sliced = false; 
+        bool sliced = false;
         Volume();
-        std::vector<std::vector<std::vector<unsigned char>>> data;
+        VoxelBuffer data;
+        size_t xStride = 1, yStride = 0, zStride = 0;
+        float spacing[3] = {1.0f, 1.0f, 1.0f};
         //result is processed data after applying MIP, AIP, MinIP
         Volume(std::string path);
         // result is processed data after applying MIP, AIP, MinIP
-        std::vector<unsigned char> slice; 
-        Volume(std::string path, int minIndex=-1, int maxIndex=-1);
+        std::vector<unsigned char> slice;
+        Volume(std::string path, int minIndex=-1, int maxIndex=-1, unsigned threads=0);
         void save(const std::string& path);
+        void allocate(int width, int height, int depth);
+        static Volume allocated(int width, int height, int depth);
+        static void convert(const std::string& dirPath, const std::string& filename, int minIndex=-1, int maxIndex=-1);
+
+        // receives slice z of a volume as w * h dense bytes; slices arrive in increasing z
+        using SliceSink = std::function<void(int z, const unsigned char* pixels)>;
+        static SliceSink sliceWriter(const std::string& path, const Volume& like);
+
+        static Volume openLazy(const std::string& dirPath, size_t budgetBytes, int minIndex=-1, int maxIndex=-1);
+        static Volume openStream(const std::string& path, int minIndex=-1, int maxIndex=-1);
+        void materialize();
+        bool isLazy() const { return cache != nullptr; }
+        const SliceCache* sliceCache() const { return cache.get(); }
+
+        unsigned char* slicePtr(int z) { return cache ? cache->slice(z) : data.data() + z * zStride; }
+        const unsigned char* slicePtr(int z) const { return cache ? cache->slice(z) : data.data() + z * zStride; }
+        unsigned char* row(int y, int z) { return slicePtr(z) + y * yStride; }
+        const unsigned char* row(int y, int z) const { return slicePtr(z) + y * yStride; }
+        unsigned char& at(int x, int y, int z) { return row(y, z)[x * xStride]; }
+        const unsigned char& at(int x, int y, int z) const { return row(y, z)[x * xStride]; }
+    private:
+        // an empty volume for the factories, without the log line of the public default constructor
+        struct Empty {};
+        explicit Volume(Empty);
+        std::shared_ptr<SliceCache> cache;
+        static std::vector<std::string> listSlices(const std::string& dirPath, int minIndex, int maxIndex);
+        void openNative(const std::string& filename, int minIndex, int maxIndex);
+        void saveNative(const std::string& filename);
 };
 
 
-#endif
\ No newline at end of file
+#endif
@@ -1,6 +1,31 @@
 #include "Blur.h"
+#include "BrickedVolume.h"
+#include "Convolution.h"
+#include "ThreadPool.h"
 #include "stb_image.h"
 #include "stb_image_write.h"
+#include <cstring>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * Create a blur filter.
+ * 
+ * @param threads The number of threads the image filters run on; 0 uses the process-wide pool.
+ */
+Blur::Blur(unsigned threads) {
+    if (threads > 0) {
+        pool = std::make_shared<ThreadPool>(threads);
+    }
+}
+
+ThreadPool& Blur::workers() {
+    return pool ? *pool : ThreadPool::shared();
+}
 
 /**
  * Applies a specified blur filter to an Image object without sigma parameter. This function
@@ -15,13 +40,45 @@
  * @acknowledgement This function was developed with the assistance of generative AI.
  */
 void Blur::apply(type filter, Image& image, int kernelSize) {
+    ImageView view = image.view();
+    apply(filter, view, kernelSize);
+}
+
+/**
+ * Applies a Gaussian blur filter to an Image object with a specified sigma value. This function
+ * specifically handles the Gaussian blur, requiring both kernel size and sigma value.
+ * 
+ * @param filter The type of blur filter to apply, expected to be Gaussian.
+ * @param image The image to apply the Gaussian blur on.
+ * @param kernelSize The size of the kernel used for blurring.
+ * @param sigma The sigma value for the Gaussian kernel.
+ * @param mode Kernel convolves with the kernelSize x kernelSize kernel; Recursive runs a recursive filter whose
+ *             cost does not depend on sigma and ignores kernelSize, which suits large sigma.
+ * 
+ * @author Prayush Udas
+ * @acknowledgement This function was developed with the assistance of generative AI.
+ */
+void Blur::apply(type filter, Image& image, int kernelSize, float sigma, gaussianMode mode) {
+    ImageView view = image.view();
+    apply(filter, view, kernelSize, sigma, mode);
+}
+
+/**
+ * Applies a 2D blur to the pixels of a view, such as an XY slice of a volume, in place. The filters read and write
+ * the rows at the view's stride, so a padded slice is blurred without being packed into an image first.
+ *
+ * @param filter The blur to apply: Median or Box.
+ * @param view The pixels to blur.
+ * @param kernelSize The size of the kernel.
+ */
+void Blur::apply(type filter, ImageView& view, int kernelSize) {
     switch (filter){
         case type::Median:
-            applyMedianBlurMultiChannel(image, kernelSize);
+            applyMedianBlurMultiChannel(view, kernelSize);
             std::cout << "[LOG] Applying Medium Blur" <<std::endl;
             break;
         case type::Box: 
-            applyBoxBlur(image, kernelSize);
+            applyBoxBlur(view, kernelSize);
             std::cout << "[LOG] Applying Box Blur"<< std::endl;
             break;
         case type::Gaussian:
@@ -33,22 +90,24 @@ void Blur::apply(type filter, Image& image, int kernelSize) {
 }
 
 /**
- * Applies a Gaussian blur filter to an Image object with a specified sigma value. This function
- * specifically handles the Gaussian blur, requiring both kernel size and sigma value.
- * 
- * @param filter The type of blur filter to apply, expected to be Gaussian.
- * @param image The image to apply the Gaussian blur on.
- * @param kernelSize The size of the kernel used for blurring.
- * @param sigma The sigma value for the Gaussian kernel.
- * 
- * @author Prayush Udas
- * @acknowledgement This function was developed with the assistance of generative AI.
+ * Applies a Gaussian blur to the pixels of a view in place.
+ *
+ * @param filter The blur to apply: Gaussian.
+ * @param view The pixels to blur.
+ * @param kernelSize The size of the kernel.
+ * @param sigma The standard deviation of the Gaussian.
+ * @param mode Kernel or Recursive, as for an Image.
  */
-void Blur::apply(type filter, Image& image, int kernelSize, float sigma) {
+void Blur::apply(type filter, ImageView& view, int kernelSize, float sigma, gaussianMode mode) {
     switch (filter){
         case type::Gaussian:
-            applyGaussianBlur(image, kernelSize, sigma);
-            std::cout << "[LOG] Applying Gaussian Blur" << std::endl;
+            if (mode == gaussianMode::Recursive && sigma >= 0.5f) {
+                applyRecursiveGaussianBlur(view, sigma);
+                std::cout << "[LOG] Applying Recursive Gaussian Blur" << std::endl;
+            } else {
+                applyGaussianBlur(view, kernelSize, sigma);
+                std::cout << "[LOG] Applying Gaussian Blur" << std::endl;
+            }
             break;
         case type::Box:
         case type::Median:
@@ -58,262 +117,484 @@ void Blur::apply(type filter, Image& image, int kernelSize, float sigma) {
     }
 }
 
-/**
- * Applies a median blur filter to a single channel of an Image. The function modifies a
- * provided result buffer with the blurred pixel values.
- * 
- * @param image The image whose channel is to be blurred.
- * @param channelNum The channel number to apply the median blur on.
- * @param kernelSize The size of the kernel used for blurring.
- * @param result The buffer where the result is to be stored.
- * 
- * @author Omar Belhaj
- * @acknowledgement This function was developed with the assistance of generative AI.
- */
-void Blur::_applyMedianBlurChannel(Image& image,int channelNum, int kernelSize, unsigned char* result){
-    int height = image.h;
-    int width = image.w;
-    int totalChannels = image.c;
-    int channel = channelNum;
-    int offset = kernelSize/2;
-    std::vector<unsigned char> window;
-    // Iterate over each pixel in the image
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            window.clear();
-
-            // Collect the pixel values within the kernel window, handling edges by replication
-            for (int ky = -offset; ky <= offset; ++ky) {
-                for (int kx = -offset; kx <= offset; ++kx) {
-                    int nx = std::min(std::max(x + kx, 0), width - 1);
-                    int ny = std::min(std::max(y + ky, 0), height - 1);
-                    window.push_back(image.data[(ny * width + nx) * totalChannels + channel]);
-                }
+namespace {
+    /**
+     * into[i] += plus[i] - minus[i] for `bins` histogram bins, eight (or four) at a time with SSE2. The counts never
+     * leave the range of Count, so the wrapping SIMD arithmetic is exact.
+     */
+    template <typename Count>
+    void slideHistogram(Count* into, const Count* plus, const Count* minus, int bins) {
+        int i = 0;
+#ifdef __SSE2__
+        constexpr int lanes = 16 / sizeof(Count);
+        for (; i + lanes <= bins; i += lanes) {
+            __m128i sum = _mm_loadu_si128(reinterpret_cast<const __m128i*>(into + i));
+            __m128i add = _mm_loadu_si128(reinterpret_cast<const __m128i*>(plus + i));
+            __m128i sub = _mm_loadu_si128(reinterpret_cast<const __m128i*>(minus + i));
+            if constexpr (sizeof(Count) == 2) {
+                sum = _mm_sub_epi16(_mm_add_epi16(sum, add), sub);
+            } else {
+                sum = _mm_sub_epi32(_mm_add_epi32(sum, add), sub);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(into + i), sum);
+        }
+#endif
+        for (; i < bins; ++i) {
+            into[i] = static_cast<Count>(into[i] + plus[i] - minus[i]);
+        }
+    }
+
+    /**
+     * Median filter one channel with running histograms (Perreault and Hebert). Every column keeps a 256-bin
+     * histogram of the 2 * radius + 1 pixels above and below the current row, plus a 16-bin coarse histogram of
+     * their high nibbles; moving down a row removes one pixel from each column and adds one. Along a row the window
+     * histogram slides by adding the column entering on the right and subtracting the one leaving on the left, and
+     * the median is found by walking at most 16 coarse and 16 fine bins. The work per pixel does not depend on the
+     * kernel size. Rows and columns outside the image are clamped to the edge, exactly as the window used to be.
+     * Only the tile of columns x0 .. x1 - 1 and rows y0 .. y1 - 1 is computed, from histograms of just the columns
+     * its windows reach. Input rows are `stride` bytes apart; `result` holds packed rows of the whole image.
+     */
+    template <typename Count>
+    void medianFilterChannel(const unsigned char* data, size_t stride, int width, int height, int channels, int channel,
+                             int radius, int x0, int x1, int y0, int y1, unsigned char* result) {
+        auto pixel = [&](int x, int y) {
+            return data[static_cast<size_t>(std::clamp(y, 0, height - 1)) * stride + x * channels + channel];
+        };
+        // histograms for the columns the tile's windows reach: the tile and a halo of `radius` either side
+        int left = std::max(x0 - radius, 0), right = std::min(x1 - 1 + radius, width - 1);
+        std::vector<Count> fine(static_cast<size_t>(right - left + 1) * 256, 0), coarse(static_cast<size_t>(right - left + 1) * 16, 0);
+        for (int x = left; x <= right; ++x) {
+            for (int dy = -radius; dy <= radius; ++dy) {
+                unsigned char value = pixel(x, y0 + dy);
+                ++fine[(x - left) * 256 + value];
+                ++coarse[(x - left) * 16 + (value >> 4)];
             }
+        }
 
-            // Sort the window to find the median
-            int n = window.size();
-            for (int i = 0; i < n - 1; i++) {
-                for (int j = 0; j < n - i - 1; j++) {
-                    if (window[j] > window[j + 1]) {
-                        // Swap window[j] and window[j + 1]
-                        unsigned char temp = window[j];
-                        window[j] = window[j + 1];
-                        window[j + 1] = temp;
-                    }
+        uint64_t side = 2 * static_cast<uint64_t>(radius) + 1;
+        uint64_t rank = side * side / 2; // the middle of the sorted window
+        Count kernelFine[256], kernelCoarse[16];
+        for (int y = y0; y < y1; ++y) {
+            if (y > y0) {
+                for (int x = left; x <= right; ++x) {
+                    unsigned char leaving = pixel(x, y - radius - 1), entering = pixel(x, y + radius);
+                    --fine[(x - left) * 256 + leaving];
+                    --coarse[(x - left) * 16 + (leaving >> 4)];
+                    ++fine[(x - left) * 256 + entering];
+                    ++coarse[(x - left) * 16 + (entering >> 4)];
                 }
             }
 
-            // Pick the middle element as the median
-            unsigned char medianValue = window[window.size() / 2];
+            std::fill(kernelFine, kernelFine + 256, 0);
+            std::fill(kernelCoarse, kernelCoarse + 16, 0);
+            for (int dx = -radius; dx <= radius; ++dx) {
+                int column = std::clamp(x0 + dx, 0, width - 1) - left;
+                for (int bin = 0; bin < 256; ++bin) {
+                    kernelFine[bin] += fine[column * 256 + bin];
+                }
+                for (int bin = 0; bin < 16; ++bin) {
+                    kernelCoarse[bin] += coarse[column * 16 + bin];
+                }
+            }
 
-            // Set the median value as the new pixel value for this channel
-            result[(y * width + x) * totalChannels + channel] = medianValue;
+            for (int x = x0; x < x1; ++x) {
+                if (x > x0) {
+                    int entering = std::min(x + radius, width - 1) - left;
+                    int leaving = std::max(x - radius - 1, 0) - left;
+                    if (entering != leaving) {
+                        slideHistogram(kernelFine, &fine[entering * 256], &fine[leaving * 256], 256);
+                        slideHistogram(kernelCoarse, &coarse[entering * 16], &coarse[leaving * 16], 16);
+                    }
+                }
+                uint64_t seen = 0;
+                int bin = 0;
+                while (seen + kernelCoarse[bin] <= rank) {
+                    seen += kernelCoarse[bin++];
+                }
+                int value = bin * 16;
+                while (seen + kernelFine[value] <= rank) {
+                    seen += kernelFine[value++];
+                }
+                result[(static_cast<size_t>(y) * width + x) * channels + channel] = static_cast<unsigned char>(value);
+            }
         }
     }
-
 }
 
 /**
- * Applies a median blur filter to all channels of an Image.
+ * Applies a median blur filter to a tile of a single channel of an Image. The function modifies a
+ * provided result buffer with the blurred pixel values. The window is kept as running
+ * histograms rather than sorted for every pixel, so the cost per pixel does not grow with
+ * the kernel size; the result is the same middle element of the edge-replicated window.
  * 
- * @param image The image to apply the median blur on.
+ * @param view The pixels whose channel is to be blurred.
+ * @param channelNum The channel number to apply the median blur on.
  * @param kernelSize The size of the kernel used for blurring.
+ * @param result The buffer where the result is to be stored, packed rows of the whole view.
+ * @param x0, x1 The columns x0 .. x1 - 1 of the tile.
+ * @param y0, y1 The rows y0 .. y1 - 1 of the tile.
  * 
  * @author Omar Belhaj
  * @acknowledgement This function was developed with the assistance of generative AI.
  */
-void Blur::applyMedianBlurMultiChannel(Image& image, int kernelSize){
-    unsigned char* result = new unsigned char[image.w * image.h* image.c];
-    //Apply the median blur separately for each channel
-    for (int ch = 0; ch < image.c; ++ch){
-        _applyMedianBlurChannel(image,ch,kernelSize, result);
+void Blur::_applyMedianBlurChannel(const ImageView& view,int channelNum, int kernelSize, unsigned char* result, int x0, int x1, int y0, int y1){
+    int radius = std::max(kernelSize, 1) / 2;
+    uint64_t side = 2 * static_cast<uint64_t>(radius) + 1;
+    // window counts must fit the histogram bins
+    if (side * side <= 0xFFFF) {
+        medianFilterChannel<uint16_t>(view.data, view.stride, view.w, view.h, view.c, channelNum, radius, x0, x1, y0, y1, result);
+    } else {
+        medianFilterChannel<uint32_t>(view.data, view.stride, view.w, view.h, view.c, channelNum, radius, x0, x1, y0, y1, result);
     }
-    
-    std::copy(result, result + image.w * image.h * image.c, image.data);
 }
 
 /**
- * Applies a box blur filter to a single channel of an Image. The function modifies a
- * provided result buffer with the blurred pixel values.
+ * Applies a median blur filter to all channels of an Image. The image is split into tiles of at least 128 columns,
+ * wide enough that the halo of kernel-radius columns either side adds at most a quarter to the column histograms,
+ * and into bands of rows when there are fewer tiles than four per thread. The tiles run on the thread pool and each
+ * filters every channel of its pixels.
  * 
- * @param image The image whose channel is to be blurred.
- * @param channel The channel number to apply the box blur on.
+ * @param view The pixels to apply the median blur on.
  * @param kernelSize The size of the kernel used for blurring.
- * @param result The buffer where the result is to be stored.
- * 
- * @author Omar Belhaj
- * @acknowledgement This function was developed with the assistance of generative AI.
  */
-void Blur::_applyBoxBlurToChannel(Image& image, int channel, int kernelSize, unsigned char* result){
-    int height = image.h;
-    int width = image.w;
-    int numChannels = image.c;
-
-    int offset = kernelSize / 2;
-    int kernelArea = kernelSize * kernelSize;
-    // Use dynamic memory allocation for rowSum to handle large images
-    int* rowSum = new int[width];
-
-    for (int y = 0; y < height; ++y) {
-        // Reset rowSum for each row
-        for (int i = 0; i < width; ++i) {
-            rowSum[i] = 0;
+void Blur::applyMedianBlurMultiChannel(ImageView& view, int kernelSize){
+    if (kernelSize > 0xFFFF) {
+        std::cout << "[ERROR] Median kernels are limited to 65535 pixels" << std::endl;
+        return;
+    }
+    if (view.w <= 0 || view.h <= 0) {
+        return;
+    }
+    int radius = std::max(kernelSize, 1) / 2;
+    int tileWidth = std::max(128, 8 * radius);
+    int columnTiles = (view.w + tileWidth - 1) / tileWidth;
+    ThreadPool& threads = workers();
+    int rowBands = std::clamp<int>((threads.size() * 4 + columnTiles - 1) / columnTiles, 1, view.h);
+
+    unsigned char* result = new unsigned char[view.w * view.h* view.c];
+    threads.parallelFor(0, columnTiles * rowBands, [&](int tile) {
+        int column = tile % columnTiles, band = tile / columnTiles;
+        int x0 = static_cast<int>(static_cast<long long>(view.w) * column / columnTiles);
+        int x1 = static_cast<int>(static_cast<long long>(view.w) * (column + 1) / columnTiles);
+        int y0 = static_cast<int>(static_cast<long long>(view.h) * band / rowBands);
+        int y1 = static_cast<int>(static_cast<long long>(view.h) * (band + 1) / rowBands);
+        //Apply the median blur separately for each channel
+        for (int ch = 0; ch < view.c; ++ch){
+            _applyMedianBlurChannel(view, ch, kernelSize, result, x0, x1, y0, y1);
         }
+    });
+    
+    size_t rowValues = static_cast<size_t>(view.w) * view.c;
+    for (int y = 0; y < view.h; ++y) {
+        std::copy_n(result + y * rowValues, rowValues, view.row(y));
+    }
+    delete[] result;
+}
 
-        // Initial row sum for the first kernel window
-        for (int ky = -offset; ky <= offset; ++ky) {
-            int ny = (y + ky < 0) ? 0 : (y + ky >= height ? height - 1 : y + ky);
-            for (int x = 0; x < width; ++x) {
-                rowSum[x] += image.data[(ny * width + x) * numChannels + channel];
-            }
+namespace {
+    /**
+     * floor(sum / area) without a hardware division: the quotient through the reciprocal is off by at most one
+     * for the sums a box window can reach, so one correction step makes it exact.
+     */
+    inline unsigned char boxMean(uint64_t sum, uint64_t area, double reciprocal) {
+        uint64_t quotient = static_cast<uint64_t>(static_cast<double>(sum) * reciprocal);
+        if (quotient * area > sum) {
+            --quotient;
+        } else if ((quotient + 1) * area <= sum) {
+            ++quotient;
         }
+        return static_cast<unsigned char>(quotient);
+    }
 
-        for (int x = 0; x < width; ++x) {
-            int sum = 0;
+    /**
+     * Box blur output rows first .. last - 1 into `result`, which holds packed rows of the whole image, from the column
+     * sums of the rows around `first` onwards. Input rows are `stride` bytes apart.
+     */
+    void boxFilterRows(const unsigned char* data, size_t stride, int width, int height, int numChannels, int radius,
+                       int first, int last, unsigned char* result) {
+        size_t rowValues = static_cast<size_t>(width) * numChannels;
+        uint64_t side = 2 * static_cast<uint64_t>(radius) + 1;
+        uint64_t area = side * side;
+        double reciprocal = 1.0 / static_cast<double>(area);
+        auto rowAt = [&](int y) { return data + static_cast<size_t>(std::clamp(y, 0, height - 1)) * stride; };
 
-            // Sum the row sums within the kernel window
-            for (int kx = -offset; kx <= offset; ++kx) {
-                int nx = (x + kx < 0) ? 0 : (x + kx >= width ? width - 1 : x + kx);
-                sum += rowSum[nx];
+        // column sums over the rows -r .. r around the first row
+        std::vector<uint64_t> columns(rowValues, 0);
+        for (int dy = -radius; dy <= radius; ++dy) {
+            const unsigned char* row = rowAt(first + dy);
+            for (size_t i = 0; i < rowValues; ++i) {
+                columns[i] += row[i];
             }
+        }
 
-            // Calculate the average and assign it as the new pixel value
-            result[(y * width + x) * numChannels + channel] = sum / kernelArea;
+        std::vector<uint64_t> sums(numChannels);
+        int inside = std::min(radius, width - 1);
+        for (int y = first; y < last; ++y) {
+            if (y > first) {
+                const unsigned char* entering = rowAt(y + radius);
+                const unsigned char* leaving = rowAt(y - radius - 1);
+                if (entering != leaving) {
+                    for (size_t i = 0; i < rowValues; ++i) {
+                        columns[i] = columns[i] + entering[i] - leaving[i];
+                    }
+                }
+            }
 
-            // Update rowSum for the next pixel, if not at the end of the row
-            if (x < width - 1) {
-                for (int ky = -offset; ky <= offset; ++ky) {
-                    int removeY = (y + ky < 0) ? 0 : (y + ky >= height ? height - 1 : y + ky);
-                    int addY = (y + ky < 0) ? 0 : (y + ky >= height ? height - 1 : y + ky);
-                    rowSum[x] -= image.data[(removeY * width + x) * numChannels + channel];
-                    rowSum[x] += image.data[(addY * width + x + 1) * numChannels + channel];
+            // columns -r .. r around column 0: the first column r + 1 times, and the last one for any beyond the image
+            for (int channel = 0; channel < numChannels; ++channel) {
+                uint64_t sum = columns[channel] * (radius + 1) + columns[(width - 1) * numChannels + channel] * (radius - inside);
+                for (int dx = 1; dx <= inside; ++dx) {
+                    sum += columns[dx * numChannels + channel];
+                }
+                sums[channel] = sum;
+            }
+            unsigned char* out = result + static_cast<size_t>(y) * rowValues;
+            for (int x = 0; x < width; ++x) {
+                if (x > 0) {
+                    const uint64_t* entering = &columns[static_cast<size_t>(std::min(x + radius, width - 1)) * numChannels];
+                    const uint64_t* leaving = &columns[static_cast<size_t>(std::max(x - radius - 1, 0)) * numChannels];
+                    for (int channel = 0; channel < numChannels; ++channel) {
+                        sums[channel] = sums[channel] + entering[channel] - leaving[channel];
+                    }
+                }
+                for (int channel = 0; channel < numChannels; ++channel) {
+                    out[x * numChannels + channel] = boxMean(sums[channel], area, reciprocal);
                 }
             }
         }
     }
-    delete[] rowSum;
 }
 
  /**
- * Applies a box blur filter to all channels of an Image.
+ * Applies a box blur filter to all channels of an Image. Every output pixel is the mean, rounded down, of the
+ * (2 * (kernelSize / 2) + 1)^2 window around it, with rows and columns outside the image clamped to the edge, so
+ * kernels up to and beyond the image size are fine. The window is summed with two separable running sums over the
+ * interleaved channels: the column sums of the 2r + 1 rows around the current row are updated by one row entering
+ * and one leaving, and each output row slides a window of r columns either side along them. The cost per pixel does
+ * not depend on the kernel size. The rows are split into bands on the thread pool, each starting its column sums
+ * from the halo of r rows above it.
  * 
- * @param image The image to apply the box blur on.
+ * @param view The pixels to apply the box blur on.
  * @param kernelSize The size of the kernel used for blurring.
  * 
  * @author Omar Belhaj
  * @acknowledgement This function was developed with the assistance of generative AI.
  */
-void Blur::applyBoxBlur(Image& image,  int kernelSize){
-    unsigned char* result = new unsigned char[image.w * image.h* image.c];
-    int numChannels = image.c;
-    for (int channel = 0; channel < numChannels; ++channel) {
-        _applyBoxBlurToChannel(image ,channel, kernelSize, result);
+void Blur::applyBoxBlur(ImageView& view, int kernelSize){
+    if (view.w <= 0 || view.h <= 0) {
+        return;
+    }
+    int radius = std::max(kernelSize, 1) / 2;
+    ThreadPool& threads = workers();
+    int bands = std::min<int>(view.h, threads.size() * 4);
+    size_t rowValues = static_cast<size_t>(view.w) * view.c;
+    unsigned char* result = new unsigned char[rowValues * view.h];
+    threads.parallelFor(0, bands, [&](int band) {
+        int first = static_cast<int>(static_cast<long long>(view.h) * band / bands);
+        int last = static_cast<int>(static_cast<long long>(view.h) * (band + 1) / bands);
+        boxFilterRows(view.data, view.stride, view.w, view.h, view.c, radius, first, last, result);
+    });
+    for (int y = 0; y < view.h; ++y) {
+        std::copy_n(result + y * rowValues, rowValues, view.row(y));
     }
-    std::copy(result, result + image.w * image.w * numChannels, image.data);
     delete[] result;
 }
 
 /**
- * Generates a Gaussian kernel with a specified size and sigma value.
+ * Applies a Gaussian blur filter to all channels of an Image. The kernel is separable, so the image is blurred with
+ * a vertical and then a horizontal 1D pass instead of the full 2D kernel, which is O(kernelSize) rather than
+ * O(kernelSize^2) work per pixel. Both passes run in 16-bit fixed point on the Convolution engine, with the weights
+ * rounded so they still sum exactly to one, and bands of rows run on the thread pool. Pixels outside the image are
+ * clamped to the edge as before, and the result is rounded to nearest, within 1 of the 2D float kernel.
  * 
- * @param kernelSize The size of the Gaussian kernel to be generated.
+ * @param view The pixels to apply the Gaussian blur on.
+ * @param kernelSize The size of the kernel used for blurring.
  * @param sigma The sigma value for the Gaussian kernel.
- * @return A 2D vector representing the Gaussian kernel.
  * 
  * @author Omar Belhaj
  * @acknowledgement This function was developed with the assistance of generative AI.
  */
-std::vector<std::vector<float>> Blur::_generateGaussianKernel(int kernelSize, float sigma){
-    std::vector<std::vector<float>> kernel(kernelSize, std::vector<float>(kernelSize));
-    float sum = 0.0f;
-    int offset = kernelSize / 2;
-
-    for (int x = -offset; x <= offset; ++x) {
-        for (int y = -offset; y <= offset; ++y) {
-            float exponent = -(x * x + y * y) / (2 * sigma * sigma);
-            float value = exp(exponent) / (2 * M_PI * sigma * sigma);
-            kernel[x + offset][y + offset] = value;
-            sum += value;
-        }
-    }
+void Blur::applyGaussianBlur(ImageView& view, int kernelSize, float sigma) {
+    Convolution::gaussian(kernelSize, sigma).apply(view, workers());
+}
 
-    // Normalize the kernel
-    for (int i = 0; i < kernelSize; ++i) {
-        for (int j = 0; j < kernelSize; ++j) {
-            kernel[i][j] /= sum;
-        }
-    }
+namespace {
+    /**
+     * Coefficients of the recursive Gaussian of Young and van Vliet: a causal pass
+     *   w[n] = B * x[n] + a1 * w[n - 1] + a2 * w[n - 2] + a3 * w[n - 3]
+     * followed by the same recursion anti-causally, which together approximate a Gaussian of standard deviation sigma
+     * with six multiply-adds per sample whatever sigma is.
+     *
+     * `edge` gives the state the anti-causal pass starts from when the signal continues with its last value forever,
+     * as the kernel path clamps at the border (Triggs and Sdika): its rows are the outputs at N, N + 1 and N + 2 minus
+     * that value, per unit of each of the last three causal outputs minus it. It is found once per sigma by running the
+     * recursion on each unit state until it has died away, rather than from the closed form.
+     */
+    struct RecursiveGaussian {
+        double B, a1, a2, a3;
+        double edge[3][3];
 
-    return kernel;
-}
+        explicit RecursiveGaussian(double sigma) {
+            double q = sigma >= 2.5 ? 0.98711 * sigma - 0.96330 : 3.97156 - 4.14554 * std::sqrt(1.0 - 0.26891 * sigma);
+            double b0 = 1.57825 + 2.44413 * q + 1.4281 * q * q + 0.422205 * q * q * q;
+            a1 = (2.44413 * q + 2.85619 * q * q + 1.26661 * q * q * q) / b0;
+            a2 = -(1.4281 * q * q + 1.26661 * q * q * q) / b0;
+            a3 = 0.422205 * q * q * q / b0;
+            B = 1.0 - (a1 + a2 + a3);
 
-/**
- * Applies a Gaussian blur filter to a single channel of an Image. The function modifies a
- * provided result buffer with the blurred pixel values using a precomputed Gaussian kernel.
- * 
- * @param image The image whose channel is to be blurred.
- * @param kernel The Gaussian kernel to use for blurring.
- * @param channel The channel number to apply the Gaussian blur on.
- * @param result The buffer where the result is to be stored.
- * 
- * @author Omar Belhaj
- * @acknowledgement This function was developed with the assistance of generative AI
- */
-void Blur::_applyGaussianBlurToChannel(Image& image,  const std::vector<std::vector<float>>& kernel, int channel, unsigned char* result){
-    int height = image.h;
-    int width = image.w;
-    int numChannels = image.c;
-    int offset = kernel.size() / 2;
-
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            float sum = 0.0f;
-
-            for (int ky = -offset; ky <= offset; ++ky) {
-                for (int kx = -offset; kx <= offset; ++kx) {
-                    int nx = x + kx;
-                    int ny = y + ky;
-
-                    // Clamping nx and ny
-                    nx = (nx < 0) ? 0 : (nx >= width) ? width - 1 : nx;
-                    ny = (ny < 0) ? 0 : (ny >= height) ? height - 1 : ny;
-
-                    sum += kernel[ky + offset][kx + offset] * image.data[(ny * width + nx) * numChannels + channel];
+            int length = static_cast<int>(40.0 * q) + 64;
+            std::vector<double> tail(length + 3);
+            for (int k = 0; k < 3; ++k) {
+                // causal outputs N - 1, N - 2, N - 3 are tail[2], tail[1], tail[0]; beyond them the input adds nothing
+                std::fill(tail.begin(), tail.end(), 0.0);
+                tail[2 - k] = 1.0;
+                for (int n = 3; n < length + 3; ++n) {
+                    tail[n] = a1 * tail[n - 1] + a2 * tail[n - 2] + a3 * tail[n - 3];
+                }
+                double y1 = 0.0, y2 = 0.0, y3 = 0.0;
+                for (int n = length + 2; n >= 3; --n) {
+                    double y = B * tail[n] + a1 * y1 + a2 * y2 + a3 * y3;
+                    y3 = y2;
+                    y2 = y1;
+                    y1 = y;
+                    if (n <= 5) {
+                        edge[n - 3][k] = y;
+                    }
                 }
             }
+        }
+    };
 
-            // Clamping the result
-            int newValue = static_cast<int>(sum);
-            newValue = (newValue < 0) ? 0 : (newValue > 255) ? 255 : newValue;
+    /**
+     * out[i] = B * in[i] + a1 * p1[i] + a2 * p2[i] + a3 * p3[i] for one step of the recursion over `len` lanes.
+     */
+    inline void recursiveStep(double* out, const double* in, const double* p1, const double* p2, const double* p3, int len,
+                              const RecursiveGaussian& g) {
+        int i = 0;
+#ifdef __SSE2__
+        const __m128d B = _mm_set1_pd(g.B), a1 = _mm_set1_pd(g.a1), a2 = _mm_set1_pd(g.a2), a3 = _mm_set1_pd(g.a3);
+        for (; i + 2 <= len; i += 2) {
+            __m128d sum = _mm_add_pd(_mm_mul_pd(B, _mm_loadu_pd(in + i)), _mm_mul_pd(a1, _mm_loadu_pd(p1 + i)));
+            sum = _mm_add_pd(sum, _mm_add_pd(_mm_mul_pd(a2, _mm_loadu_pd(p2 + i)), _mm_mul_pd(a3, _mm_loadu_pd(p3 + i))));
+            _mm_storeu_pd(out + i, sum);
+        }
+#endif
+        for (; i < len; ++i) {
+            out[i] = (g.B * in[i] + g.a1 * p1[i]) + (g.a2 * p2[i] + g.a3 * p3[i]);
+        }
+    }
+
+    /**
+     * Run the causal and anti-causal passes over `count` steps in place. Step n is the `len` lanes at data + n * stride,
+     * so the recursion runs down a strip of columns with every column in its own lane, or along a strip of interleaved
+     * rows. The signal is continued with its first and last values at both ends. `scratch` holds 5 * len values.
+     */
+    void recursiveGaussian(double* data, size_t stride, int count, int len, const RecursiveGaussian& g, double* scratch) {
+        double* first = scratch;
+        double* last = scratch + len;
+        double* after = scratch + 2 * len; // anti-causal outputs at count, count + 1, count + 2
+        std::copy(data, data + len, first);
+        std::copy(data + (count - 1) * stride, data + (count - 1) * stride + len, last);
+        auto causal = [&](int n) -> const double* { return n < 0 ? first : data + n * stride; };
+        for (int n = 0; n < count; ++n) {
+            double* row = data + n * stride;
+            recursiveStep(row, row, causal(n - 1), causal(n - 2), causal(n - 3), len, g);
+        }
 
-            result[(y * width + x) * numChannels + channel] = static_cast<unsigned char>(newValue);
+        for (int j = 0; j < 3; ++j) {
+            double* out = after + j * len;
+            const double* w1 = causal(count - 1);
+            const double* w2 = causal(count - 2);
+            const double* w3 = causal(count - 3);
+            for (int i = 0; i < len; ++i) {
+                double u = last[i];
+                out[i] = u + g.edge[j][0] * (w1[i] - u) + g.edge[j][1] * (w2[i] - u) + g.edge[j][2] * (w3[i] - u);
+            }
+        }
+        auto antiCausal = [&](int n) -> const double* { return n >= count ? after + (n - count) * len : data + n * stride; };
+        for (int n = count - 1; n >= 0; --n) {
+            double* row = data + n * stride;
+            recursiveStep(row, row, antiCausal(n + 1), antiCausal(n + 2), antiCausal(n + 3), len, g);
         }
     }
 }
 
 /**
- * Applies a Gaussian blur filter to all channels of an Image. This function utilizes the
- * _generateGaussianKernel and _applyGaussianBlurToChannel helper functions to perform the
- * blurring operation.
- * 
- * @param image The image to apply the Gaussian blur on.
- * @param kernelSize The size of the kernel used for blurring.
- * @param sigma The sigma value for the Gaussian kernel.
- * 
- * @author Omar Belhaj
- * @acknowledgement This function was developed with the assistance of generative AI.
+ * Applies a recursive (IIR) approximation of a Gaussian blur to all channels of an Image, for sigma where even the
+ * separable kernel gets long. Every row and then every column is filtered with the causal and anti-causal passes of
+ * Young and van Vliet, six multiply-adds per pixel and pass whatever sigma is, with the edges continued with the
+ * border pixel like the kernel path. The row passes run on strips of 16 rows interleaved side by side in SIMD lanes,
+ * and the column passes down strips of 64 interleaved values, one per lane; the strips of each pass run on the
+ * thread pool. The recursion runs in double precision, since the feedback of a wide filter amplifies float rounding
+ * to whole grey levels; between the passes the image is kept as floats. The result is rounded to the nearest value
+ * and is within a few grey levels of an exact Gaussian.
+ *
+ * @param view The pixels to apply the Gaussian blur on.
+ * @param sigma The standard deviation of the Gaussian, at least 0.5.
  */
-void Blur::applyGaussianBlur(Image& image, int kernelSize, float sigma) {
-    int numChannels = image.c;
-    
-    std::vector<std::vector<float>> kernel = _generateGaussianKernel(kernelSize, sigma);
-    unsigned char* result = new unsigned char[image.w * image.h* image.c];
-    for (int channel = 0; channel < numChannels; ++channel) {
-        _applyGaussianBlurToChannel(image, kernel, channel, result);
+void Blur::applyRecursiveGaussianBlur(ImageView& view, float sigma) {
+    int width = view.w;
+    int height = view.h;
+    int numChannels = view.c;
+    if (width <= 0 || height <= 0) {
+        return;
     }
-    std::copy(result, result + image.w*image.h*image.c, image.data);
-    delete[] result;
+    const int lanes = 64, stripRows = 16;
+    RecursiveGaussian g(sigma);
+    size_t rowValues = static_cast<size_t>(width) * numChannels;
+    std::vector<float> values(rowValues * height);
+
+    // each pass runs bands of strips on the pool, every band with its own buffers
+    ThreadPool& threads = workers();
+    auto forStrips = [&](int strips, auto filterStrip) {
+        int bands = std::min<int>(strips, threads.size() * 4);
+        threads.parallelFor(0, bands, [&](int band) {
+            int first = static_cast<int>(static_cast<long long>(strips) * band / bands);
+            int last = static_cast<int>(static_cast<long long>(strips) * (band + 1) / bands);
+            filterStrip(first, last);
+        });
+    };
+
+    // rows: strips of `stripRows` rows, interleaved so that step x of channel c is the values at (x * c + channel) * stripRows
+    forStrips((height + stripRows - 1) / stripRows, [&](int first, int last) {
+        std::vector<double> strip(rowValues * stripRows), scratch(5 * stripRows);
+        for (int y0 = first * stripRows; y0 < last * stripRows; y0 += stripRows) {
+            for (int lane = 0; lane < stripRows; ++lane) {
+                const unsigned char* row = view.row(std::min(y0 + lane, height - 1));
+                for (size_t i = 0; i < rowValues; ++i) {
+                    strip[i * stripRows + lane] = row[i];
+                }
+            }
+            for (int channel = 0; channel < numChannels; ++channel) {
+                recursiveGaussian(strip.data() + channel * stripRows, static_cast<size_t>(numChannels) * stripRows, width, stripRows, g, scratch.data());
+            }
+            for (int lane = 0; lane < stripRows && y0 + lane < height; ++lane) {
+                float* row = values.data() + (y0 + lane) * rowValues;
+                for (size_t i = 0; i < rowValues; ++i) {
+                    row[i] = static_cast<float>(strip[i * stripRows + lane]);
+                }
+            }
+        }
+    });
+
+    // columns: strips of up to 64 values of every row, each value a lane
+    forStrips(static_cast<int>((rowValues + lanes - 1) / lanes), [&](int first, int last) {
+        std::vector<double> columns(static_cast<size_t>(lanes) * height), scratch(5 * lanes);
+        for (size_t i0 = static_cast<size_t>(first) * lanes; i0 < std::min<size_t>(static_cast<size_t>(last) * lanes, rowValues); i0 += lanes) {
+            int len = static_cast<int>(std::min<size_t>(lanes, rowValues - i0));
+            for (int y = 0; y < height; ++y) {
+                std::copy_n(values.data() + y * rowValues + i0, len, columns.data() + static_cast<size_t>(y) * len);
+            }
+            recursiveGaussian(columns.data(), len, height, len, g, scratch.data());
+            for (int y = 0; y < height; ++y) {
+                unsigned char* out = view.row(y) + i0;
+                const double* column = columns.data() + static_cast<size_t>(y) * len;
+                for (int i = 0; i < len; ++i) {
+                    out[i] = static_cast<unsigned char>(std::clamp(column[i], 0.0, 255.0) + 0.5);
+                }
+            }
+        }
+    });
 }
 
 /**
@@ -323,15 +604,20 @@ void Blur::applyGaussianBlur(Image& image, int kernelSize, float sigma) {
  * @param volume The volume to apply the blur filter on.
  * @param kernelSize The size of the kernel used for blurring.
  * @param sigma The sigma value for the Gaussian kernel.
+ * @param volumeLayout The memory layout to filter in, SliceMajor by default.
  * 
  * @author Yunjie Li
  * @acknowledgement This function was developed with the assistance of generative AI.
  */
-void Blur::apply(type filter, Volume& volume, int kernelSize, float sigma){
+void Blur::apply(type filter, Volume& volume, int kernelSize, float sigma, layout volumeLayout){
     switch (filter){
         case type::Gaussian:
             std::cout <<"[LOG] Applying Guassian Blur To Volume" << std::endl;
-            applyGaussianBlurToVolume(volume, kernelSize, sigma);
+            if (volumeLayout == layout::Bricked) {
+                applyGaussianBlurToBricks(volume, kernelSize, sigma);
+            } else {
+                applyGaussianBlurToVolume(volume, kernelSize, sigma);
+            }
             break;
         default:
             std::cerr << "[LOG] Wrong arguments" << std::endl;
@@ -345,15 +631,20 @@ void Blur::apply(type filter, Volume& volume, int kernelSize, float sigma){
  * @param filter The type of blur filter to apply.
  * @param volume The volume to apply the blur filter on.
  * @param kernelSize The size of the kernel used for blurring.
+ * @param volumeLayout The memory layout to filter in, SliceMajor by default.
  * 
  * @author Yunjie Li
  * @acknowledgement This function was developed with the assistance of generative AI.
  */
-void Blur::apply(type filter, Volume& volume, int kernelSize){
+void Blur::apply(type filter, Volume& volume, int kernelSize, layout volumeLayout){
     switch (filter){
         case type::Median:
             std::cout << "[LOG] Applying Median Blur To Volume" << std::endl;
-            applyMedianBlurToVolume(volume, kernelSize);
+            if (volumeLayout == layout::Bricked) {
+                applyMedianBlurToBricks(volume, kernelSize);
+            } else {
+                applyMedianBlurToVolume(volume, kernelSize);
+            }
             break;
         default:
             std::cerr << "[ERROR] Wrong arguments" << std::endl;
@@ -371,13 +662,15 @@ void Blur::apply(type filter, Volume& volume, int kernelSize){
  * @acknowledgement This function was developed with the assistance of generative AI.
  */
 void Blur::applyMedianBlurToVolume(Volume& volume, int kernelSize){
+    volume.materialize(); // the filter reads neighbourhoods across many slices and replaces every voxel
     std::cerr << "[LOG] Median Filter " << kernelSize << "x" << kernelSize << "x" << kernelSize << " is Processing..." << std::endl;
-    std::vector<std::vector<std::vector<unsigned char>>> blurData(volume.l + 1, std::vector<std::vector<unsigned char>>(volume.h + 1, std::vector<unsigned char>(volume.w + 1)));
+    VoxelBuffer blurData(volume.data.size()); // same layout and strides as the source volume
 
-    for (int z = 1; z <= volume.l; ++z) {
-        for (int y = 1; y <= volume.h; ++y) {
-            for (int x = 1; x <= volume.w; ++x) {
-                blurData[z][y][x] = _CalculateMedianValue(z, y, x, kernelSize, volume); // copy data, ignore index 0
+    for (int z = 0; z < volume.l; ++z) {
+        for (int y = 0; y < volume.h; ++y) {
+            unsigned char* row = blurData.data() + z * volume.zStride + y * volume.yStride;
+            for (int x = 0; x < volume.w; ++x) {
+                row[x * volume.xStride] = _CalculateMedianValue(z, y, x, kernelSize, volume);
             }
         }
     }
@@ -396,14 +689,16 @@ void Blur::applyMedianBlurToVolume(Volume& volume, int kernelSize){
  * @acknowledgement This function was developed with the assistance of generative AI.
  */
 void Blur::applyGaussianBlurToVolume(Volume& volume, int kernelSize, float sigma) {
+    volume.materialize(); // the filter reads neighbourhoods across many slices and replaces every voxel
     std::vector<double> weights = _Gaussian3DKernel(kernelSize, sigma); // generate 3D Gaussian kernel
     std::cerr << "[LOG] Gaussian Filter " << kernelSize << "x" << kernelSize << "x" << kernelSize << " is Processing..." << std::endl;
-    std::vector<std::vector<std::vector<unsigned char>>> blurData(volume.l + 1, std::vector<std::vector<unsigned char>>(volume.h + 1, std::vector<unsigned char>(volume.w + 1)));
+    VoxelBuffer blurData(volume.data.size()); // same layout and strides as the source volume
 
-    for (int z = 1; z <= volume.l; ++z) {
-        for (int y = 1; y <= volume.h; ++y) {
-            for (int x = 1; x <= volume.w; ++x) {
-                blurData[z][y][x] = _CalculateWeightedAverage(z, y, x, weights, kernelSize, volume); // copy data, ignore index 0
+    for (int z = 0; z < volume.l; ++z) {
+        for (int y = 0; y < volume.h; ++y) {
+            unsigned char* row = blurData.data() + z * volume.zStride + y * volume.yStride;
+            for (int x = 0; x < volume.w; ++x) {
+                row[x * volume.xStride] = _CalculateWeightedAverage(z, y, x, weights, kernelSize, volume);
             }
         }
     }
@@ -483,8 +778,8 @@ unsigned char Blur::_CalculateWeightedAverage(const int& z, const int& y, const
                 int nx = x + dx;
                 
                 // check if it is within the boundary, if not, consider it as 0
-                if (nz > 0 && nz <= volume.l && ny > 0 && ny <= volume.h && nx > 0 && nx <= volume.w) {
-                    sum += volume.data[nz][ny][nx] * weights[index];
+                if (nz >= 0 && nz < volume.l && ny >= 0 && ny < volume.h && nx >= 0 && nx < volume.w) {
+                    sum += volume.at(nx, ny, nz) * weights[index];
                     totalWeights += weights[index];
                 }
                 
@@ -520,13 +815,22 @@ unsigned char Blur::_CalculateMedianValue(const int& z, const int& y, const int&
                 int nx = x + dx;
                 
                 // check if it is within the boundary
-                if (nz > 0 && nz <= volume.l && ny > 0 && ny <= volume.h && nx > 0 && nx <= volume.w) {
-                    values.push_back(volume.data[nz][ny][nx]);
+                if (nz >= 0 && nz < volume.l && ny >= 0 && ny < volume.h && nx >= 0 && nx < volume.w) {
+                    values.push_back(volume.at(nx, ny, nz));
                 }
             }
         }
     }
 
+    return _MedianOf(values);
+}
+
+/**
+ * Select the median of a neighbourhood, averaging the two middle values when the count is even.
+ * 
+ * @param values: the neighbourhood values, reordered in place
+ */
+unsigned char Blur::_MedianOf(std::vector<unsigned char>& values) {
     int valuesSize = values.size();
     if (valuesSize % 2 == 0) {
         return (Utilities::QuickSelectMedian(values, 0, valuesSize-1, valuesSize/2-1) + Utilities::QuickSelectMedian(values, 0, valuesSize-1, valuesSize/2)) / 2;
@@ -534,3 +838,234 @@ unsigned char Blur::_CalculateMedianValue(const int& z, const int& y, const int&
         return Utilities::QuickSelectMedian(values, 0, valuesSize-1, valuesSize/2);
     }
 }
+
+/**
+ * Weighted average of a clipped 3D window, used by the bricked and streaming Gaussian filters. Taps are
+ * visited in the same dz, dy, dx order as _CalculateWeightedAverage, so the results are identical.
+ * 
+ * @param rowAt Returns a pointer to the window row at offsets (dz, dy), positioned at the centre column.
+ * @param lo, hi The first and last offset inside the volume along x, y and z.
+ * @param weights The 3D Gaussian kernel.
+ * @param size The size of the kernel.
+ */
+template <typename RowAt>
+unsigned char Blur::_WeightedAverageOf(RowAt rowAt, const int* lo, const int* hi, const std::vector<double>& weights, int size) {
+    int halfSize = size / 2;
+    double sum = 0.0;
+    double totalWeights = 0.0;
+    for (int dz = lo[2]; dz <= hi[2]; ++dz) {
+        for (int dy = lo[1]; dy <= hi[1]; ++dy) {
+            const unsigned char* row = rowAt(dz, dy);
+            const double* weightRow = &weights[((dz + halfSize) * size + (dy + halfSize)) * size + halfSize];
+            for (int dx = lo[0]; dx <= hi[0]; ++dx) {
+                sum += row[dx] * weightRow[dx];
+                totalWeights += weightRow[dx];
+            }
+        }
+    }
+    return static_cast<unsigned char>(std::clamp(sum / totalWeights, 0.0, 255.0));
+}
+
+/**
+ * Median of a clipped 3D window, used by the bricked and streaming median filters.
+ * 
+ * @param rowAt Returns a pointer to the window row at offsets (dz, dy), positioned at the centre column.
+ * @param lo, hi The first and last offset inside the volume along x, y and z.
+ * @param values Scratch storage for the window values, reused between voxels.
+ */
+template <typename RowAt>
+unsigned char Blur::_MedianOfWindow(RowAt rowAt, const int* lo, const int* hi, std::vector<unsigned char>& values) {
+    values.clear();
+    for (int dz = lo[2]; dz <= hi[2]; ++dz) {
+        for (int dy = lo[1]; dy <= hi[1]; ++dy) {
+            const unsigned char* row = rowAt(dz, dy);
+            values.insert(values.end(), row + lo[0], row + hi[0] + 1);
+        }
+    }
+    return _MedianOf(values);
+}
+
+/**
+ * Run a 3D filter brick by brick. The volume is copied into halo-padded bricks, and for every voxel the
+ * filter receives a row lookup into its brick together with the kernel offsets that stay inside the
+ * volume, so no per-tap bounds checks are needed.
+ * 
+ * @param volume The volume to filter; its voxels are replaced by the result.
+ * @param kernelSize The size of the kernel.
+ * @param filterVoxel Called as filterVoxel(rowAt, lo, hi), see _WeightedAverageOf.
+ */
+template <typename VoxelFilter>
+void Blur::_filterBricks(Volume& volume, int kernelSize, VoxelFilter filterVoxel) {
+    volume.materialize();
+    int halfSize = kernelSize / 2;
+    BrickedVolume bricks(volume, halfSize);
+    VoxelBuffer blurData(volume.data.size()); // same layout and strides as the source volume
+    int size = bricks.brickSize;
+    int span = bricks.span;
+
+    for (int bz = 0; bz < bricks.bricksZ; ++bz) {
+        for (int by = 0; by < bricks.bricksY; ++by) {
+            for (int bx = 0; bx < bricks.bricksX; ++bx) {
+                const unsigned char* brick = bricks.brick(bx, by, bz);
+                int zEnd = std::min(size, volume.l - bz * size);
+                int yEnd = std::min(size, volume.h - by * size);
+                int xEnd = std::min(size, volume.w - bx * size);
+                for (int lz = 0; lz < zEnd; ++lz) {
+                    int z = bz * size + lz;
+                    for (int ly = 0; ly < yEnd; ++ly) {
+                        int y = by * size + ly;
+                        const unsigned char* centre = brick + (static_cast<size_t>(lz + halfSize) * span + ly + halfSize) * span + halfSize;
+                        unsigned char* out = blurData.data() + z * volume.zStride + y * volume.yStride + bx * size * volume.xStride;
+                        int lo[3] = {0, std::max(-halfSize, -y), std::max(-halfSize, -z)};
+                        int hi[3] = {0, std::min(halfSize, volume.h - 1 - y), std::min(halfSize, volume.l - 1 - z)};
+                        for (int lx = 0; lx < xEnd; ++lx) {
+                            int x = bx * size + lx;
+                            lo[0] = std::max(-halfSize, -x);
+                            hi[0] = std::min(halfSize, volume.w - 1 - x);
+                            const unsigned char* voxel = centre + lx;
+                            auto rowAt = [voxel, span](int dz, int dy) { return voxel + (dz * span + dy) * span; };
+                            out[lx * volume.xStride] = filterVoxel(rowAt, lo, hi);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    volume.data.swap(blurData);
+}
+
+/**
+ * Apply gaussian blur to volume, traversing it as halo-padded bricks.
+ * 
+ * @param volume The volume to apply the blur filter on.
+ * @param kernelSize The size of the kernel used for blurring.
+ * @param sigma The sigma value for the Gaussian kernel.
+ */
+void Blur::applyGaussianBlurToBricks(Volume& volume, int kernelSize, float sigma) {
+    std::vector<double> weights = _Gaussian3DKernel(kernelSize, sigma);
+    std::cerr << "[LOG] Bricked Gaussian Filter " << kernelSize << "x" << kernelSize << "x" << kernelSize << " is Processing..." << std::endl;
+    _filterBricks(volume, kernelSize, [&](auto rowAt, const int* lo, const int* hi) {
+        return _WeightedAverageOf(rowAt, lo, hi, weights, kernelSize);
+    });
+    std::cout << "[LOG] 3D Gaussian done." << std::endl;
+}
+
+/**
+ * Apply median blur to volume, traversing it as halo-padded bricks.
+ * 
+ * @param volume The volume to apply the blur filter on.
+ * @param kernelSize The size of the kernel used for blurring.
+ */
+void Blur::applyMedianBlurToBricks(Volume& volume, int kernelSize) {
+    std::cerr << "[LOG] Bricked Median Filter " << kernelSize << "x" << kernelSize << "x" << kernelSize << " is Processing..." << std::endl;
+    std::vector<unsigned char> values;
+    values.reserve(kernelSize * kernelSize * kernelSize);
+    _filterBricks(volume, kernelSize, [&](auto rowAt, const int* lo, const int* hi) {
+        return _MedianOfWindow(rowAt, lo, hi, values);
+    });
+    std::cout << "[LOG] 3D Median done." << std::endl;
+}
+
+/**
+ * Run a 3D filter over a rolling window of slices. Only the 2 * (kernelSize / 2) + 1 input slices the
+ * current output slice depends on are held, copied out of the volume as they are first needed, so a lazy
+ * or memory-mapped volume is read exactly once, front to back, and never held in full.
+ * 
+ * @param volume The volume to read; it is not modified.
+ * @param kernelSize The size of the kernel.
+ * @param sink Receives each output slice, in z order, as soon as it is complete.
+ * @param filterVoxel Called as filterVoxel(rowAt, lo, hi), see _WeightedAverageOf.
+ */
+template <typename VoxelFilter>
+void Blur::_streamSlices(const Volume& volume, int kernelSize, const Volume::SliceSink& sink, VoxelFilter filterVoxel) {
+    int halfSize = kernelSize / 2;
+    int windowSlices = 2 * halfSize + 1;
+    int w = volume.w;
+    size_t sliceBytes = static_cast<size_t>(w) * volume.h;
+    std::vector<unsigned char> window(windowSlices * sliceBytes); // slice z lives in slot z % windowSlices
+    std::vector<unsigned char> output(sliceBytes);
+    std::vector<const unsigned char*> slices(windowSlices); // slices[dz + halfSize] is slice z + dz
+
+    auto load = [&](int z) {
+        unsigned char* slot = window.data() + (z % windowSlices) * sliceBytes;
+        const unsigned char* source = volume.slicePtr(z);
+        for (int y = 0; y < volume.h; ++y) {
+            std::memcpy(slot + static_cast<size_t>(y) * w, source + y * volume.yStride, w);
+        }
+    };
+    for (int z = 0; z < std::min(halfSize, volume.l); ++z) {
+        load(z);
+    }
+
+    for (int z = 0; z < volume.l; ++z) {
+        if (z + halfSize < volume.l) {
+            load(z + halfSize); // overwrites slice z - halfSize - 1, which is no longer needed
+        }
+        int lo[3] = {0, 0, std::max(-halfSize, -z)};
+        int hi[3] = {0, 0, std::min(halfSize, volume.l - 1 - z)};
+        for (int dz = lo[2]; dz <= hi[2]; ++dz) {
+            slices[dz + halfSize] = window.data() + ((z + dz) % windowSlices) * sliceBytes;
+        }
+        for (int y = 0; y < volume.h; ++y) {
+            lo[1] = std::max(-halfSize, -y);
+            hi[1] = std::min(halfSize, volume.h - 1 - y);
+            unsigned char* out = output.data() + static_cast<size_t>(y) * w;
+            for (int x = 0; x < w; ++x) {
+                lo[0] = std::max(-halfSize, -x);
+                hi[0] = std::min(halfSize, w - 1 - x);
+                size_t centre = static_cast<size_t>(y) * w + x;
+                auto rowAt = [&slices, centre, halfSize, w](int dz, int dy) { return slices[dz + halfSize] + centre + dy * w; };
+                out[x] = filterVoxel(rowAt, lo, hi);
+            }
+        }
+        sink(z, output.data());
+    }
+}
+
+/**
+ * Apply a 3D gaussian blur without holding the volume or the result in memory. Peak memory is
+ * 2 * (kernelSize / 2) + 2 slices plus whatever the source volume keeps resident, so a volume opened with
+ * Volume::openLazy or from a native ".vol" file can be filtered even when it does not fit in RAM. The
+ * output is identical to apply(Gaussian, volume, kernelSize, sigma).
+ * 
+ * @param filter The type of blur filter to apply (only Gaussian is accepted here).
+ * @param volume The volume to read.
+ * @param kernelSize The size of the kernel used for blurring.
+ * @param sigma The sigma value for the Gaussian kernel.
+ * @param sink Receives each blurred slice as soon as it is complete, e.g. Volume::sliceWriter.
+ */
+void Blur::applyStreaming(type filter, const Volume& volume, int kernelSize, float sigma, const Volume::SliceSink& sink) {
+    if (filter != type::Gaussian) {
+        std::cerr << "[ERROR] Invalid filter type" << std::endl;
+        return;
+    }
+    std::vector<double> weights = _Gaussian3DKernel(kernelSize, sigma);
+    std::cerr << "[LOG] Streaming Gaussian Filter " << kernelSize << "x" << kernelSize << "x" << kernelSize << " is Processing..." << std::endl;
+    _streamSlices(volume, kernelSize, sink, [&](auto rowAt, const int* lo, const int* hi) {
+        return _WeightedAverageOf(rowAt, lo, hi, weights, kernelSize);
+    });
+    std::cout << "[LOG] 3D Gaussian done." << std::endl;
+}
+
+/**
+ * Apply a 3D median blur without holding the volume or the result in memory, as the streaming
+ * Gaussian does. The output is identical to apply(Median, volume, kernelSize).
+ * 
+ * @param filter The type of blur filter to apply (only Median is accepted here).
+ * @param volume The volume to read.
+ * @param kernelSize The size of the kernel used for blurring.
+ * @param sink Receives each blurred slice as soon as it is complete, e.g. Volume::sliceWriter.
+ */
+void Blur::applyStreaming(type filter, const Volume& volume, int kernelSize, const Volume::SliceSink& sink) {
+    if (filter != type::Median) {
+        std::cerr << "[ERROR] Invalid filter type" << std::endl;
+        return;
+    }
+    std::cerr << "[LOG] Streaming Median Filter " << kernelSize << "x" << kernelSize << "x" << kernelSize << " is Processing..." << std::endl;
+    std::vector<unsigned char> values;
+    values.reserve(kernelSize * kernelSize * kernelSize);
+    _streamSlices(volume, kernelSize, sink, [&](auto rowAt, const int* lo, const int* hi) {
+        return _MedianOfWindow(rowAt, lo, hi, values);
+    });
+    std::cout << "[LOG] 3D Median done." << std::endl;
+}
@@ -0,0 +1,47 @@
+#include "BrickedVolume.h"
+#include <algorithm>
+#include <cstring>
+
+/**
+ * Copy a volume into halo-padded bricks. Each stored row of a brick is copied from one row of the
+ * source with a single memcpy; only the parts of the halo outside the volume are left zero.
+ *
+ * @param volume The volume to copy.
+ * @param halo The number of voxels of padding on every side of a brick, i.e. the largest filter radius.
+ * @param brickSize The edge length of a brick without its halo.
+ */
+BrickedVolume::BrickedVolume(const Volume& volume, int halo, int brickSize)
+    : w(volume.w), h(volume.h), l(volume.l), brickSize(brickSize), halo(halo) {
+    bricksX = (w + brickSize - 1) / brickSize;
+    bricksY = (h + brickSize - 1) / brickSize;
+    bricksZ = (l + brickSize - 1) / brickSize;
+    span = brickSize + 2 * halo;
+    brickBytes = static_cast<size_t>(span) * span * span;
+    bricks = VoxelBuffer(brickBytes * bricksX * bricksY * bricksZ);
+
+    for (int bz = 0; bz < bricksZ; ++bz) {
+        for (int by = 0; by < bricksY; ++by) {
+            for (int bx = 0; bx < bricksX; ++bx) {
+                unsigned char* out = brick(bx, by, bz);
+                // range of source x covered by this brick and its halo, clipped to the volume
+                int x0 = bx * brickSize - halo;
+                int xBegin = std::max(x0, 0);
+                int xEnd = std::min(x0 + span, w);
+                for (int lz = 0; lz < span; ++lz) {
+                    int z = bz * brickSize - halo + lz;
+                    if (z < 0 || z >= l) {
+                        continue;
+                    }
+                    for (int ly = 0; ly < span; ++ly) {
+                        int y = by * brickSize - halo + ly;
+                        if (y < 0 || y >= h || xEnd <= xBegin) {
+                            continue;
+                        }
+                        std::memcpy(out + (static_cast<size_t>(lz) * span + ly) * span + (xBegin - x0),
+                                    volume.row(y, z) + xBegin * volume.xStride, xEnd - xBegin);
+                    }
+                }
+            }
+        }
+    }
+}
@@ -20,6 +20,7 @@ void ColourFilter::apply(cf filter, Image& image){
         case cf::GrayScale:
             GrayscaleFilter(image);
             std::cout<<"[LOG] Applying Grayscale"<<std::endl;
+            break;
         case cf::histHSL:
             histogramEqHSL(image);
             std::cout<<"[LOG] Applying Histogram Equaliser using HSL"<< std::endl;
@@ -27,9 +28,11 @@ void ColourFilter::apply(cf filter, Image& image){
         case cf::histHSV:
             histogramEqHSV(image);
             std::cout<<"[LOG] Applying Histogram Equaliser using HSV" << std::endl;
+            break;
         case cf::histGREY:
             histogramEqGrayscale(image);
             std::cout<<"[LOG] Applying Histogram Equaliser using Grayscale" << std::endl;
+            break;
         default:
             std::cout<< "[ERROR] Please apply correct filter for ColourFilter"<< std::endl;
             break;
@@ -140,6 +143,7 @@ void ColourFilter::apply(cf filter, Image& image, int threshold){
         case cf::saltNpepper:
             saltNpepperFilter(image, threshold);
             std::cout<<"[LOG] Applying Salt N Pepper filter"<<std::endl;
+            break;
         case cf::Brightness:
         case cf::GrayScale: 
         default:
@@ -148,6 +152,62 @@ void ColourFilter::apply(cf filter, Image& image, int threshold){
     }
 }
 
+namespace {
+    /**
+     * Whether `filter` can run on `view`. The grayscale conversion and the HSL and HSV filters read three colour
+     * channels per pixel, which a view of fewer channels, such as any slice of a volume, does not have; a contiguous
+     * view aliases the voxels, so they would read and write past the view into the rest of the volume.
+     */
+    bool acceptsView(ColourFilter::cf filter, const ImageView& view) {
+        switch (filter) {
+            case ColourFilter::GrayScale:
+            case ColourFilter::thHSL:
+            case ColourFilter::thHSV:
+            case ColourFilter::histHSL:
+            case ColourFilter::histHSV:
+                if (view.c < 3) {
+                    std::cout << "[ERROR] This colour filter needs a view with RGB channels" << std::endl;
+                    return false;
+                }
+                return true;
+            default:
+                return true;
+        }
+    }
+}
+
+/**
+ * Applies a colour filter to the pixels of a view, such as a slice of a volume, in place. A contiguous view is
+ * filtered without copying; see Filter::applyToView. The overloads match those taking an Image, except that the
+ * filters that need RGB pixels leave a view with fewer channels unchanged.
+ *
+ * @param filter The colour filter to apply.
+ * @param view The pixels to filter.
+ */
+void ColourFilter::apply(cf filter, ImageView& view){
+    if (acceptsView(filter, view)) {
+        applyToView(view, [&](Image& image) { apply(filter, image); });
+    }
+}
+
+void ColourFilter::apply(cf filter, ImageView& view, std::string mode){
+    if (acceptsView(filter, view)) {
+        applyToView(view, [&](Image& image) { apply(filter, image, mode); });
+    }
+}
+
+void ColourFilter::apply(cf filter, ImageView& view, double noisePercentage){
+    if (acceptsView(filter, view)) {
+        applyToView(view, [&](Image& image) { apply(filter, image, noisePercentage); });
+    }
+}
+
+void ColourFilter::apply(cf filter, ImageView& view, int threshold){
+    if (acceptsView(filter, view)) {
+        applyToView(view, [&](Image& image) { apply(filter, image, threshold); });
+    }
+}
+
 /**
  * Applies "salt and pepper" noise to an image at a specified noise percentage. This function iterates over each pixel in the image and, based on the noise percentage, randomly determines whether to convert the pixel to either pure black ("pepper") or pure white ("salt"). This effect is applied uniformly across all channels of a pixel, affecting the image in place.
  *
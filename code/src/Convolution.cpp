@@ -0,0 +1,302 @@
+#include "Convolution.h"
+#include "ConvolutionKernels.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+namespace {
+    // Bounds on the sum of |weights| * 2^shift that keep every 32-bit sum, rounding bias included, from overflowing:
+    // for 8-bit pixels, and for the 16-bit intermediate rows of a separable kernel.
+    const double byteSumLimit = 8.4e6;
+    const double shortSumLimit = 61440.0;
+
+    /**
+     * The largest shift up to 14 at which every weight, scaled by 2^shift and rounded, fits in 16 bits and the sum
+     * of their magnitudes stays within `limit`.
+     */
+    int fixedShift(const std::vector<float>& weights, double limit) {
+        double largest = 0.0, total = 0.0;
+        for (float weight : weights) {
+            largest = std::max(largest, std::fabs(static_cast<double>(weight)));
+            total += std::fabs(static_cast<double>(weight));
+        }
+        for (int shift = 14; shift >= 0; --shift) {
+            double scale = std::ldexp(1.0, shift);
+            if (largest * scale + 1.0 <= 32767.0 && total * scale + weights.size() <= limit) {
+                return shift;
+            }
+        }
+        throw std::invalid_argument("convolution weights are too large for 16-bit fixed point");
+    }
+
+    /**
+     * Round the weights to integers at scale 2^shift so that they sum exactly to the scaled sum of the weights,
+     * rounded: every weight is rounded down and the missing units go to the weights with the largest remainders,
+     * nearest the middle of the kernel first.
+     */
+    std::vector<int16_t> quantize(const std::vector<float>& weights, int shift) {
+        int taps = static_cast<int>(weights.size());
+        double scale = std::ldexp(1.0, shift);
+        std::vector<int16_t> fixed(taps);
+        std::vector<double> remainder(taps);
+        double exact = 0.0;
+        long long total = 0;
+        for (int t = 0; t < taps; ++t) {
+            double scaled = weights[t] * scale;
+            double lower = std::floor(scaled);
+            fixed[t] = static_cast<int16_t>(lower);
+            remainder[t] = scaled - lower;
+            exact += scaled;
+            total += static_cast<long long>(lower);
+        }
+        std::vector<int> order(taps);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+            if (remainder[a] != remainder[b]) {
+                return remainder[a] > remainder[b];
+            }
+            return std::abs(2 * a - (taps - 1)) < std::abs(2 * b - (taps - 1));
+        });
+        long long missing = std::clamp<long long>(std::llround(exact) - total, 0, taps);
+        for (long long k = 0; k < missing; ++k) {
+            ++fixed[order[k]];
+        }
+        return fixed;
+    }
+
+    /**
+     * Copy `rows` kernel rows of `taps` weights into rows padded with a zero weight to an even number of taps.
+     */
+    std::vector<int16_t> padTaps(const std::vector<int16_t>& weights, int taps, int rows) {
+        int stride = taps + (taps & 1);
+        std::vector<int16_t> padded(static_cast<size_t>(stride) * rows, 0);
+        for (int row = 0; row < rows; ++row) {
+            std::copy(weights.begin() + row * taps, weights.begin() + (row + 1) * taps, padded.begin() + row * stride);
+        }
+        return padded;
+    }
+
+    /**
+     * Fill the `before` pixels in front of a row and the `after` pixels behind it with its first and last pixel.
+     */
+    void replicateEdges(int16_t* row, int width, int channels, int before, int after) {
+        for (int x = 1; x <= before; ++x) {
+            std::copy(row, row + channels, row - x * channels);
+        }
+        const int16_t* last = row + (width - 1) * channels;
+        for (int x = 1; x <= after; ++x) {
+            std::copy(last, last + channels, row + (width - 1 + x) * channels);
+        }
+    }
+}
+
+/**
+ * Create a general kernel.
+ *
+ * @param weights The width * height weights, row by row.
+ * @param width The number of taps along x.
+ * @param height The number of taps along y.
+ */
+Convolution::Convolution(const std::vector<float>& weights, int width, int height)
+    : width(width), height(height), separable(false) {
+    if (width <= 0 || height <= 0 || weights.size() != static_cast<size_t>(width) * height) {
+        throw std::invalid_argument("convolution kernel needs width * height weights");
+    }
+    horizontalShift = fixedShift(weights, byteSumLimit);
+    horizontalWeights = padTaps(quantize(weights, horizontalShift), width, height);
+}
+
+/**
+ * Create a separable kernel.
+ *
+ * @param horizontal The weights along x.
+ * @param vertical The weights along y.
+ */
+Convolution::Convolution(const std::vector<float>& horizontal, const std::vector<float>& vertical)
+    : width(static_cast<int>(horizontal.size())), height(static_cast<int>(vertical.size())), separable(true) {
+    if (horizontal.empty() || vertical.empty()) {
+        throw std::invalid_argument("convolution kernel needs at least one weight along each axis");
+    }
+    verticalShift = fixedShift(vertical, byteSumLimit);
+    verticalWeights = padTaps(quantize(vertical, verticalShift), height, 1);
+    horizontalShift = fixedShift(horizontal, shortSumLimit);
+    horizontalWeights = padTaps(quantize(horizontal, horizontalShift), width, 1);
+
+    // keep as many fractional bits between the passes as the range of the vertical sums leaves room for in 16 bits
+    long long positive = 0, negative = 0;
+    for (int16_t weight : verticalWeights) {
+        (weight > 0 ? positive : negative) += std::abs(weight);
+    }
+    long long range = 255 * std::max(positive, negative);
+    intermediateBits = verticalShift;
+    while (intermediateBits > 0 && (range >> (verticalShift - intermediateBits)) + 1 > 32767) {
+        --intermediateBits;
+    }
+}
+
+/**
+ * The separable Gaussian of the given size. A sigma of zero or less gives the limit of a narrowing Gaussian, which
+ * leaves the image unchanged.
+ *
+ * @param kernelSize The size of the kernel; the weights cover offsets -kernelSize / 2 .. kernelSize / 2.
+ * @param sigma The standard deviation of the Gaussian in pixels.
+ */
+Convolution Convolution::gaussian(int kernelSize, float sigma) {
+    int radius = std::max(kernelSize, 1) / 2;
+    std::vector<double> weights(2 * radius + 1, 0.0);
+    double sum = 0.0;
+    for (int i = -radius; i <= radius; ++i) {
+        weights[i + radius] = sigma > 0.0f ? std::exp(-(i * i) / (2.0 * sigma * sigma)) : (i == 0 ? 1.0 : 0.0);
+        sum += weights[i + radius];
+    }
+    std::vector<float> kernel(weights.size());
+    for (size_t i = 0; i < weights.size(); ++i) {
+        kernel[i] = static_cast<float>(weights[i] / sum);
+    }
+    return Convolution(kernel, kernel);
+}
+
+/**
+ * The separable mean over a square window.
+ *
+ * @param kernelSize The size of the window; it covers offsets -kernelSize / 2 .. kernelSize / 2.
+ */
+Convolution Convolution::box(int kernelSize) {
+    int side = 2 * (std::max(kernelSize, 1) / 2) + 1;
+    std::vector<float> kernel(side, 1.0f / side);
+    return Convolution(kernel, kernel);
+}
+
+/**
+ * Convolve the image in place.
+ *
+ * @param image The image to filter; all of its channels are filtered.
+ */
+void Convolution::apply(Image& image) const {
+    apply(image, ThreadPool::shared());
+}
+
+/**
+ * Convolve the image in place on the given pool, in bands of rows.
+ *
+ * @param image The image to filter; all of its channels are filtered.
+ * @param pool The threads to run the bands on.
+ */
+void Convolution::apply(Image& image, ThreadPool& pool) const {
+    ImageView view = image.view();
+    apply(view, pool);
+}
+
+/**
+ * Convolve the pixels of a view in place, e.g. a slice of a volume.
+ *
+ * @param view The pixels to filter; all of its channels are filtered.
+ */
+void Convolution::apply(ImageView& view) const {
+    apply(view, ThreadPool::shared());
+}
+
+/**
+ * Convolve the pixels of a view in place on the given pool. The rows are read straight from the view at its stride,
+ * so a padded slice is not packed first; the bands write packed rows that are copied back once all of them are done.
+ *
+ * @param view The pixels to filter; all of its channels are filtered.
+ * @param pool The threads to run the bands on.
+ */
+void Convolution::apply(ImageView& view, ThreadPool& pool) const {
+    if (view.w <= 0 || view.h <= 0) {
+        return;
+    }
+    size_t rowValues = static_cast<size_t>(view.w) * view.c;
+    std::vector<unsigned char> result(rowValues * view.h);
+    int bands = std::min<int>(view.h, pool.size() * 4);
+    pool.parallelFor(0, bands, [&](int band) {
+        int first = static_cast<int>(static_cast<long long>(view.h) * band / bands);
+        int last = static_cast<int>(static_cast<long long>(view.h) * (band + 1) / bands);
+        filterRows(view, first, last, result.data() + first * rowValues);
+    });
+    for (int y = 0; y < view.h; ++y) {
+        std::copy_n(result.data() + y * rowValues, rowValues, view.row(y));
+    }
+}
+
+/**
+ * Compute output rows first .. last - 1 of the view into `out`, which holds (last - first) packed rows.
+ */
+void Convolution::filterRows(const ImageView& image, int first, int last, unsigned char* out) const {
+    if (separable) {
+        filterRowsSeparable(image, first, last, out);
+    } else {
+        filterRows2D(image, first, last, out);
+    }
+}
+
+/**
+ * The separable passes: for every output row the clamped input rows around it are summed down the columns into a
+ * padded 16-bit row with `intermediateBits` fractional bits, whose ends replicate the edge pixels, and that row is
+ * convolved along x.
+ */
+void Convolution::filterRowsSeparable(const ImageView& image, int first, int last, unsigned char* out) const {
+    const ConvolutionKernels& kernels = ConvolutionKernels::active();
+    int channels = image.c;
+    int rowValues = image.w * channels;
+    int before = width / 2, after = width - before; // one more than needed after, for the zero weight of odd kernels
+    std::vector<int16_t> padded(static_cast<size_t>(before + image.w + after) * channels);
+    int16_t* row = padded.data() + before * channels;
+    std::vector<int32_t> sum(rowValues);
+    std::vector<const unsigned char*> rows(height + 1);
+    auto rowAt = [&](int y) -> const unsigned char* { return image.row(std::clamp(y, 0, image.h - 1)); };
+
+    for (int y = first; y < last; ++y) {
+        for (int t = 0; t < height; ++t) {
+            rows[t] = rowAt(y + t - height / 2);
+        }
+        rows[height] = rows[height - 1];
+        kernels.columns(sum.data(), rows.data(), verticalWeights.data(), height, rowValues);
+        kernels.narrowToShort(row, sum.data(), verticalShift - intermediateBits, rowValues);
+        replicateEdges(row, image.w, channels, before, after);
+
+        std::fill(sum.begin(), sum.end(), 0);
+        kernels.accumulateRow(sum.data(), padded.data(), horizontalWeights.data(), width, channels, rowValues);
+        kernels.narrowToByte(out + static_cast<size_t>(y - first) * rowValues, sum.data(), horizontalShift + intermediateBits, rowValues);
+    }
+}
+
+/**
+ * The direct 2D convolution: each output row accumulates one row pass per kernel row over the padded 16-bit copies
+ * of the input rows around it. The copies are cached in `height` slots by input row, so every input row is widened
+ * once as the rows move down the image.
+ */
+void Convolution::filterRows2D(const ImageView& image, int first, int last, unsigned char* out) const {
+    const ConvolutionKernels& kernels = ConvolutionKernels::active();
+    int channels = image.c;
+    int rowValues = image.w * channels;
+    int before = width / 2, after = width - before;
+    size_t paddedValues = static_cast<size_t>(before + image.w + after) * channels;
+    std::vector<int16_t> cache(paddedValues * height);
+    std::vector<int> cached(height, -1);
+    auto paddedRow = [&](int y) -> const int16_t* {
+        int source = std::clamp(y, 0, image.h - 1);
+        int16_t* padded = cache.data() + (source % height) * paddedValues;
+        if (cached[source % height] != source) {
+            const unsigned char* pixels = image.row(source);
+            std::copy(pixels, pixels + rowValues, padded + before * channels);
+            replicateEdges(padded + before * channels, image.w, channels, before, after);
+            cached[source % height] = source;
+        }
+        return padded;
+    };
+
+    int stride = width + (width & 1);
+    std::vector<int32_t> sum(rowValues);
+    for (int y = first; y < last; ++y) {
+        std::fill(sum.begin(), sum.end(), 0);
+        for (int ky = 0; ky < height; ++ky) {
+            kernels.accumulateRow(sum.data(), paddedRow(y + ky - height / 2), horizontalWeights.data() + ky * stride,
+                                  width, channels, rowValues);
+        }
+        kernels.narrowToByte(out + static_cast<size_t>(y - first) * rowValues, sum.data(), horizontalShift, rowValues);
+    }
+}
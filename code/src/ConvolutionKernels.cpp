@@ -0,0 +1,240 @@
+#include "ConvolutionKernels.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CONVOLUTION_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+    // two neighbouring 16-bit weights as the 32-bit lane pmaddwd multiplies a pair of pixels by
+    inline int32_t weightPair(const int16_t* weights) {
+        int32_t pair;
+        std::memcpy(&pair, weights, sizeof(pair));
+        return pair;
+    }
+
+    inline int32_t roundingBias(int shift) {
+        return shift > 0 ? 1 << (shift - 1) : 0;
+    }
+
+    // the scalar versions start at `first` so the SIMD versions can finish their rows with them
+    void columnsFrom(int32_t* sum, const unsigned char* const* rows, const int16_t* weights, int taps, int first, int n) {
+        for (int i = first; i < n; ++i) {
+            int32_t value = 0;
+            for (int t = 0; t < taps; ++t) {
+                value += weights[t] * rows[t][i];
+            }
+            sum[i] = value;
+        }
+    }
+
+    void accumulateRowFrom(int32_t* sum, const int16_t* row, const int16_t* weights, int taps, int step, int first, int n) {
+        for (int i = first; i < n; ++i) {
+            int32_t value = sum[i];
+            for (int t = 0; t < taps; ++t) {
+                value += weights[t] * row[i + t * step];
+            }
+            sum[i] = value;
+        }
+    }
+
+    void narrowToShortFrom(int16_t* out, const int32_t* sum, int shift, int first, int n) {
+        int32_t bias = roundingBias(shift);
+        for (int i = first; i < n; ++i) {
+            out[i] = static_cast<int16_t>(std::clamp((sum[i] + bias) >> shift, -32768, 32767));
+        }
+    }
+
+    void narrowToByteFrom(unsigned char* out, const int32_t* sum, int shift, int first, int n) {
+        int32_t bias = roundingBias(shift);
+        for (int i = first; i < n; ++i) {
+            out[i] = static_cast<unsigned char>(std::clamp((sum[i] + bias) >> shift, 0, 255));
+        }
+    }
+
+    void columnsScalar(int32_t* sum, const unsigned char* const* rows, const int16_t* weights, int taps, int n) {
+        columnsFrom(sum, rows, weights, taps, 0, n);
+    }
+
+    void accumulateRowScalar(int32_t* sum, const int16_t* row, const int16_t* weights, int taps, int step, int n) {
+        accumulateRowFrom(sum, row, weights, taps, step, 0, n);
+    }
+
+    void narrowToShortScalar(int16_t* out, const int32_t* sum, int shift, int n) {
+        narrowToShortFrom(out, sum, shift, 0, n);
+    }
+
+    void narrowToByteScalar(unsigned char* out, const int32_t* sum, int shift, int n) {
+        narrowToByteFrom(out, sum, shift, 0, n);
+    }
+
+#ifdef CONVOLUTION_KERNELS_X86
+    // SSE2: 16 pixels per step down the columns and 8 along a row. Interleaving the pixels of two taps into 16-bit
+    // pairs lets one pmaddwd multiply both by their weights and add them.
+    __attribute__((target("sse2")))
+    void columnsSSE2(int32_t* sum, const unsigned char* const* rows, const int16_t* weights, int taps, int n) {
+        const __m128i zero = _mm_setzero_si128();
+        int i = 0;
+        for (; i + 16 <= n; i += 16) {
+            __m128i acc[4] = {zero, zero, zero, zero};
+            for (int t = 0; t < taps; t += 2) {
+                __m128i weight = _mm_set1_epi32(weightPair(weights + t));
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[t] + i));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[t + 1] + i));
+                __m128i lo = _mm_unpacklo_epi8(a, b);
+                __m128i hi = _mm_unpackhi_epi8(a, b);
+                acc[0] = _mm_add_epi32(acc[0], _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), weight));
+                acc[1] = _mm_add_epi32(acc[1], _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), weight));
+                acc[2] = _mm_add_epi32(acc[2], _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), weight));
+                acc[3] = _mm_add_epi32(acc[3], _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), weight));
+            }
+            for (int part = 0; part < 4; ++part) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(sum + i + 4 * part), acc[part]);
+            }
+        }
+        columnsFrom(sum, rows, weights, taps, i, n);
+    }
+
+    __attribute__((target("sse2")))
+    void accumulateRowSSE2(int32_t* sum, const int16_t* row, const int16_t* weights, int taps, int step, int n) {
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sum + i));
+            __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sum + i + 4));
+            for (int t = 0; t < taps; t += 2) {
+                __m128i weight = _mm_set1_epi32(weightPair(weights + t));
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i + t * step));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i + (t + 1) * step));
+                lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), weight));
+                hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), weight));
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(sum + i), lo);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(sum + i + 4), hi);
+        }
+        accumulateRowFrom(sum, row, weights, taps, step, i, n);
+    }
+
+    __attribute__((target("sse2")))
+    void narrowToShortSSE2(int16_t* out, const int32_t* sum, int shift, int n) {
+        const __m128i bias = _mm_set1_epi32(roundingBias(shift));
+        const __m128i count = _mm_cvtsi32_si128(shift);
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m128i lo = _mm_sra_epi32(_mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sum + i)), bias), count);
+            __m128i hi = _mm_sra_epi32(_mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sum + i + 4)), bias), count);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(lo, hi));
+        }
+        narrowToShortFrom(out, sum, shift, i, n);
+    }
+
+    __attribute__((target("sse2")))
+    void narrowToByteSSE2(unsigned char* out, const int32_t* sum, int shift, int n) {
+        const __m128i bias = _mm_set1_epi32(roundingBias(shift));
+        const __m128i count = _mm_cvtsi32_si128(shift);
+        int i = 0;
+        for (; i + 16 <= n; i += 16) {
+            __m128i words[2];
+            for (int half = 0; half < 2; ++half) {
+                const __m128i* in = reinterpret_cast<const __m128i*>(sum + i + 8 * half);
+                __m128i lo = _mm_sra_epi32(_mm_add_epi32(_mm_loadu_si128(in), bias), count);
+                __m128i hi = _mm_sra_epi32(_mm_add_epi32(_mm_loadu_si128(in + 1), bias), count);
+                words[half] = _mm_packs_epi32(lo, hi);
+            }
+            // saturating to int16 and then to 0 .. 255 is the same as clamping to 0 .. 255
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(words[0], words[1]));
+        }
+        narrowToByteFrom(out, sum, shift, i, n);
+    }
+
+    // AVX2: 16 pixels per pmaddwd. Unpacking works within each 128-bit half, so the sums are kept as pixels
+    // 0-3 and 8-11 in one register and 4-7 and 12-15 in the other, and put back in order when stored.
+    __attribute__((target("avx2")))
+    void columnsAVX2(int32_t* sum, const unsigned char* const* rows, const int16_t* weights, int taps, int n) {
+        int i = 0;
+        for (; i + 16 <= n; i += 16) {
+            __m256i lo = _mm256_setzero_si256();
+            __m256i hi = _mm256_setzero_si256();
+            for (int t = 0; t < taps; t += 2) {
+                __m256i weight = _mm256_set1_epi32(weightPair(weights + t));
+                __m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[t] + i)));
+                __m256i b = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[t + 1] + i)));
+                lo = _mm256_add_epi32(lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), weight));
+                hi = _mm256_add_epi32(hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), weight));
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(sum + i), _mm256_permute2x128_si256(lo, hi, 0x20));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(sum + i + 8), _mm256_permute2x128_si256(lo, hi, 0x31));
+        }
+        columnsFrom(sum, rows, weights, taps, i, n);
+    }
+
+    __attribute__((target("avx2")))
+    void accumulateRowAVX2(int32_t* sum, const int16_t* row, const int16_t* weights, int taps, int step, int n) {
+        int i = 0;
+        for (; i + 16 <= n; i += 16) {
+            __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sum + i));
+            __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sum + i + 8));
+            __m256i lo = _mm256_permute2x128_si256(first, second, 0x20);
+            __m256i hi = _mm256_permute2x128_si256(first, second, 0x31);
+            for (int t = 0; t < taps; t += 2) {
+                __m256i weight = _mm256_set1_epi32(weightPair(weights + t));
+                __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i + t * step));
+                __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i + (t + 1) * step));
+                lo = _mm256_add_epi32(lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), weight));
+                hi = _mm256_add_epi32(hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), weight));
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(sum + i), _mm256_permute2x128_si256(lo, hi, 0x20));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(sum + i + 8), _mm256_permute2x128_si256(lo, hi, 0x31));
+        }
+        accumulateRowFrom(sum, row, weights, taps, step, i, n);
+    }
+#endif
+
+    // narrowing runs once per pixel rather than once per tap, so AVX2 keeps the SSE2 versions
+    const ConvolutionKernels kernelTable[] = {
+        {columnsScalar, accumulateRowScalar, narrowToShortScalar, narrowToByteScalar},
+#ifdef CONVOLUTION_KERNELS_X86
+        {columnsSSE2, accumulateRowSSE2, narrowToShortSSE2, narrowToByteSSE2},
+        {columnsAVX2, accumulateRowAVX2, narrowToShortSSE2, narrowToByteSSE2},
+#endif
+    };
+
+    /**
+     * The widest instruction set this CPU supports, up to `limit`.
+     */
+    ConvolutionKernels::Isa supportedIsa(ConvolutionKernels::Isa limit) {
+#ifdef CONVOLUTION_KERNELS_X86
+        __builtin_cpu_init();
+        if (limit >= ProjectionKernels::AVX2 && __builtin_cpu_supports("avx2")) {
+            return ProjectionKernels::AVX2;
+        }
+        if (limit >= ProjectionKernels::SSE2 && __builtin_cpu_supports("sse2")) {
+            return ProjectionKernels::SSE2;
+        }
+#else
+        (void)limit;
+#endif
+        return ProjectionKernels::Scalar;
+    }
+
+    std::atomic<int>& currentIsa() {
+        static std::atomic<int> isa{supportedIsa(ProjectionKernels::AVX512)};
+        return isa;
+    }
+}
+
+const ConvolutionKernels& ConvolutionKernels::active() {
+    return kernelTable[currentIsa().load(std::memory_order_relaxed)];
+}
+
+ConvolutionKernels::Isa ConvolutionKernels::activeIsa() {
+    return static_cast<Isa>(currentIsa().load(std::memory_order_relaxed));
+}
+
+ConvolutionKernels::Isa ConvolutionKernels::select(Isa isa) {
+    Isa chosen = supportedIsa(isa);
+    currentIsa().store(chosen, std::memory_order_relaxed);
+    return chosen;
+}
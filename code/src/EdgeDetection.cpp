@@ -21,7 +21,9 @@
  */
 void EdgeDetection::_EdgeDetect(Image& image, type method) {
     ColourFilter cc;
-    cc.apply(cc.GrayScale, image); 
+    if (image.c >= 3) { // a single-channel image, such as a slice of a volume, is already grey
+        cc.apply(cc.GrayScale, image);
+    }
     int gx[3][3], gy[3][3];
 
     switch (method) {
@@ -131,3 +133,14 @@ void EdgeDetection::_EdgeDetect(Image& image, type method) {
 void EdgeDetection::apply(Image& image, type method){
     _EdgeDetect(image, method);
 }
+
+/**
+ * Applies edge detection to the pixels of a view, such as a slice of a volume, in place. A contiguous view is
+ * filtered without copying; see Filter::applyToView.
+ *
+ * @param view The pixels to filter; like an Image, it is left with one channel.
+ * @param method The edge detection algorithm to apply.
+ */
+void EdgeDetection::apply(ImageView& view, type method){
+    applyToView(view, [&](Image& image) { _EdgeDetect(image, method); });
+}
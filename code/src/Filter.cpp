@@ -3,6 +3,48 @@
 
 #include "stb_image_write.h"
 
+/**
+ * Run `filter` on the pixels of `view`. The ColourFilter and EdgeDetection filters work on Images with packed
+ * rows, so a contiguous view is handed to them as an Image that aliases the viewed memory and is filtered in place
+ * without copying. A strided view, e.g. an XY slice of a volume whose rows are padded, is packed into one scratch
+ * image first and its rows are copied back afterwards. If the filter changes the number of channels, as the
+ * grayscale conversion does, the view's channel count (and, for a contiguous view, its stride) is updated to
+ * describe the result.
+ *
+ * @param view The pixels to filter in place.
+ * @param filter An Image filter.
+ */
+void Filter::applyToView(ImageView& view, const std::function<void(Image&)>& filter){
+    if (view.w <= 0 || view.h <= 0) {
+        return;
+    }
+    bool contiguous = view.contiguous();
+    std::vector<unsigned char> scratch;
+    Image image;
+    image.w = view.w;
+    image.h = view.h;
+    image.c = view.c;
+    if (contiguous) {
+        image.data = view.data;
+    } else {
+        size_t rowBytes = static_cast<size_t>(view.w) * view.c;
+        scratch.resize(rowBytes * view.h);
+        for (int y = 0; y < view.h; ++y) {
+            std::memcpy(&scratch[y * rowBytes], view.row(y), rowBytes);
+        }
+        image.data = scratch.data();
+    }
 
+    filter(image);
 
-
+    view.c = image.c;
+    if (contiguous) {
+        view.stride = static_cast<size_t>(view.w) * view.c;
+    } else {
+        size_t rowBytes = static_cast<size_t>(view.w) * view.c;
+        for (int y = 0; y < view.h; ++y) {
+            std::memcpy(view.row(y), &scratch[y * rowBytes], rowBytes);
+        }
+    }
+    image.data = nullptr; // the Image only borrowed the pixels
+}
@@ -53,4 +53,17 @@ void Image::save(std::string path){
     std::cerr << "[LOG][ImageSave] Error in saving file" << std::endl; 
     }
     std::cout << "[LOG][ImageSave] " << this->path << " saved as " <<  path<< std::endl;
-}
\ No newline at end of file
+}
+
+/**
+ * Saves the viewed pixels in PNG format, reading each row in place.
+ *
+ * @param path The file path where the image should be saved.
+ */
+void ImageView::save(const std::string& path) const{
+    if(!stbi_write_png(path.c_str(), w, h, c, data, static_cast<int>(stride))){
+        std::cerr << "[LOG][ImageSave] Error in saving file" << std::endl;
+        return;
+    }
+    std::cout << "[LOG][ImageSave] View saved as " << path << std::endl;
+}
@@ -1,6 +1,109 @@
 #include "Projection.h"
+#include "ProjectionKernels.h"
+#include "ThreadPool.h"
 #include <algorithm>
 #include <iostream>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+
+namespace {
+    /**
+     * Call sliceTask(z, slice) on the calling thread for every slice of a lazy volume, in order. When the cache
+     * can hold two slices and there is a second thread, slice z + 1 is decoded on another thread while slice z is
+     * being processed, so decoding overlaps the reduction. The slice being processed is always the most recently
+     * used one, so decoding the next slice can only evict an older one.
+     */
+    template <typename SliceTask>
+    void streamLazySlices(const Volume& volume, ThreadPool& workers, SliceTask sliceTask) {
+        if (volume.l <= 0) {
+            return;
+        }
+        bool prefetch = volume.sliceCache()->capacitySlices() >= 2 && workers.size() > 1;
+        const unsigned char* slice = volume.slicePtr(0);
+        for (int z = 0; z < volume.l; ++z) {
+            const unsigned char* next = nullptr;
+            if (prefetch && z + 1 < volume.l) {
+                workers.parallelFor(0, 2, [&](int task) {
+                    if (task == 0) {
+                        next = volume.slicePtr(z + 1);
+                    } else {
+                        sliceTask(z, slice);
+                    }
+                });
+            } else {
+                sliceTask(z, slice);
+                if (z + 1 < volume.l) {
+                    next = volume.slicePtr(z + 1);
+                }
+            }
+            slice = next;
+        }
+    }
+}
+
+/**
+ * Create a projection that runs on `threads` threads; 0 shares the process-wide pool.
+ */
+Projection::Projection(unsigned threads) {
+    if (threads > 0) {
+        pool = std::make_shared<ThreadPool>(threads);
+    }
+}
+
+/**
+ * Call rowTask(y, z, row) for every row of the volume, splitting the output image into bands of rows that
+ * are processed in parallel. Along z the output rows are the volume's y rows; along x and y they are its
+ * slices. Each output row belongs to exactly one band and is reduced in the same order as a serial loop, so
+ * the result does not depend on the thread count.
+ *
+ * A lazy volume is walked one slice at a time instead, fetching each slice before its rows are handed out, so no
+ * thread can have a slice evicted from under it; the next slice is decoded meanwhile if the cache has room for
+ * both. Its rows are then split across threads, except along y where every row of a slice folds into the same
+ * output row and the slice is reduced on one thread. A volume from Volume::openStream is projected this way
+ * while holding only two of its slices.
+ *
+ * @param volume The volume to walk.
+ * @param axis The projection axis, which decides how the output is banded.
+ * @param rowTask Receives the row index, the slice index and a pointer to the row's voxels.
+ */
+void Projection::forEachRow(const Volume& volume, Axis axis, const std::function<void(int, int, const unsigned char*)>& rowTask) {
+    ThreadPool& workers = pool ? *pool : ThreadPool::shared();
+
+    if (volume.isLazy()) {
+        int bands = axis == axisY ? 1 : std::min<int>(volume.h, workers.size() * 4);
+        streamLazySlices(volume, workers, [&](int z, const unsigned char* slice) {
+            workers.parallelFor(0, bands, [&](int band) {
+                int first = static_cast<int>(static_cast<long long>(volume.h) * band / bands);
+                int last = static_cast<int>(static_cast<long long>(volume.h) * (band + 1) / bands);
+                for (int y = first; y < last; ++y) {
+                    rowTask(y, z, slice + y * volume.yStride);
+                }
+            });
+        });
+        return;
+    }
+
+    int outputRows = axis == axisZ ? volume.h : volume.l;
+    int bands = std::min<int>(outputRows, workers.size() * 4); // a few bands per thread to balance the load
+    workers.parallelFor(0, bands, [&](int band) {
+        int first = static_cast<int>(static_cast<long long>(outputRows) * band / bands);
+        int last = static_cast<int>(static_cast<long long>(outputRows) * (band + 1) / bands);
+        if (axis == axisZ) {
+            for (int z = 0; z < volume.l; ++z) {
+                for (int y = first; y < last; ++y) {
+                    rowTask(y, z, volume.row(y, z));
+                }
+            }
+        } else {
+            for (int z = first; z < last; ++z) {
+                for (int y = 0; y < volume.h; ++y) {
+                    rowTask(y, z, volume.row(y, z));
+                }
+            }
+        }
+    });
+}
 
 /**
  * @brief Applies the Maximum Intensity Projection (MIP) to a volumetric dataset.
@@ -19,23 +122,13 @@
  */
 
 void Projection::MIP(Volume& volume) {
+    const ProjectionKernels& kernels = ProjectionKernels::active(); // widest SIMD set this CPU supports
     std::vector<unsigned char> result(volume.w * volume.h, 0); // Initialize to record maximum intensity values
-    // Iterate over each pixel
-    for (int y = 1; y <= volume.h; ++y) {
-        for (int x = 1; x <= volume.w; ++x) {
-            unsigned char maxIntensity = 0;
-            // Find maximum intensity value in z-direction
-            for (int z = 1; z <= volume.l; ++z) {
-                unsigned char intensity = volume.data[z][y][x]; // Single channel value
-                if (intensity > maxIntensity) {
-                    maxIntensity = intensity;
-                }
-            }
-            // Write maximum intensity value into result image
-            result[(y-1) * volume.w + x-1] = maxIntensity;
-        }
-    }
-    volume.slice = result;
+    // Stream through the slices in memory order, keeping the running maximum for each pixel
+    forEachRow(volume, axisZ, [&](int y, int, const unsigned char* row) {
+        kernels.maxRow(&result[y * volume.w], row, volume.w);
+    });
+    volume.slice = std::move(result);
 }
 
 
@@ -56,22 +149,19 @@ void Projection::MIP(Volume& volume) {
  */
 
 void Projection::AIP(Volume& volume){
+    const ProjectionKernels& kernels = ProjectionKernels::active();
     std::vector<unsigned char> result(volume.w * volume.h, 0);
+    std::vector<unsigned int> sumIntensity(volume.w * volume.h, 0);
 
-    // Iterate over each pixel
-    for (int y = 1; y <= volume.h; ++y) {
-        for (int x = 1; x <= volume.w; ++x) {
-            unsigned int sumIntensity = 0;
-            // Calculate sum of intensity values in z-direction
-            for (int z = 1; z <= volume.l; ++z) {
-                sumIntensity += volume.data[z][y][x]; // Accumulate intensity values
-            }
-            // Calculate average intensity value and write it into result image
-            unsigned char avgIntensity = static_cast<unsigned char>(sumIntensity / volume.l);
-            result[(y-1) * volume.w + (x-1)] = avgIntensity;
-        }
+    // Accumulate intensity values slice by slice in memory order
+    forEachRow(volume, axisZ, [&](int y, int, const unsigned char* row) {
+        kernels.sumRow(&sumIntensity[y * volume.w], row, volume.w);
+    });
+    // Calculate average intensity value and write it into result image
+    for (size_t i = 0; i < result.size(); ++i) {
+        result[i] = static_cast<unsigned char>(sumIntensity[i] / volume.l);
     }
-    volume.slice = result;
+    volume.slice = std::move(result);
 }
 
 
@@ -92,27 +182,272 @@ void Projection::AIP(Volume& volume){
 
 
 void Projection::MinIP(Volume& volume) {
+    const ProjectionKernels& kernels = ProjectionKernels::active();
     std::vector<unsigned char> result(volume.w * volume.h, 255); // Initialize to maximum to find minimum
-    // Iterate over each pixel
-    for (int y = 1; y <= volume.h; ++y) {
-        for (int x = 1; x <= volume.w; ++x) {
-            unsigned char minIntensity = 255;
-            // Find minimum intensity value in z-direction
-            for (int z = 1; z <= volume.l; ++z) {
-                unsigned char intensity = volume.data[z][y][x]; // Single channel value
-                if (intensity < minIntensity) {
-                    minIntensity = intensity;
+    // Stream through the slices in memory order, keeping the running minimum for each pixel
+    forEachRow(volume, axisZ, [&](int y, int, const unsigned char* row) {
+        kernels.minRow(&result[y * volume.w], row, volume.w);
+    });
+    volume.slice = std::move(result);
+}
+
+
+/**
+ * @brief Computes several projections of a volume in a single traversal of its voxels.
+ *
+ * Each row of every slice is read once and folded into all of the requested accumulators while it is still
+ * in cache, so asking for MIP, MinIP, AIP and the standard deviation together costs one sweep over memory
+ * instead of four. MIP, MinIP and AIP are identical to the individual projections. The standard deviation
+ * projection is the population standard deviation along the axis, rounded to the nearest intensity.
+ *
+ * The volume is always read in memory order. Along z and y every row is folded element-wise into a row of
+ * accumulators (output row y, or output row z); along x the row itself is the set of voxels being reduced,
+ * so it is folded into a single accumulator with a horizontal reduction.
+ *
+ * @param methods The projections to compute; duplicates are ignored.
+ * @param volume The volume to project; it is not modified.
+ * @param axis The axis to project along. The output is w x h for z, w x l for y and h x l for x.
+ * @return One image per requested projection.
+ */
+std::map<Projection::Proj, std::vector<unsigned char>> Projection::applyFused(const std::vector<Proj>& methods, const Volume& volume, Axis axis) {
+    const ProjectionKernels& kernels = ProjectionKernels::active();
+    auto wants = [&](Proj method) { return std::find(methods.begin(), methods.end(), method) != methods.end(); };
+    bool wantMIP = wants(projMIP), wantMinIP = wants(projMinIP), wantAIP = wants(projAIP), wantStdDev = wants(projStdDev);
+    int width, height;
+    outputSize(volume, axis, width, height);
+    size_t pixels = static_cast<size_t>(width) * height;
+    uint64_t n = axis == axisZ ? volume.l : (axis == axisY ? volume.h : volume.w); // voxels reduced per pixel
+
+    std::map<Proj, std::vector<unsigned char>> results;
+    std::vector<unsigned char> maxima(wantMIP ? pixels : 0, 0);
+    std::vector<unsigned char> minima(wantMinIP ? pixels : 0, 255);
+    std::vector<unsigned int> sums(wantAIP || wantStdDev ? pixels : 0, 0);
+    std::vector<uint64_t> sumSquares(wantStdDev ? pixels : 0, 0);
+
+    if (axis == axisX) {
+        forEachRow(volume, axis, [&](int y, int z, const unsigned char* row) {
+            size_t pixel = static_cast<size_t>(z) * volume.h + y;
+            if (wantMIP) maxima[pixel] = kernels.maxOfRow(row, volume.w);
+            if (wantMinIP) minima[pixel] = kernels.minOfRow(row, volume.w);
+            if (!sums.empty()) sums[pixel] = static_cast<unsigned int>(kernels.sumOfRow(row, volume.w));
+            if (wantStdDev) sumSquares[pixel] = kernels.sumSquaresOfRow(row, volume.w);
+        });
+    } else {
+        forEachRow(volume, axis, [&](int y, int z, const unsigned char* row) {
+            size_t offset = static_cast<size_t>(axis == axisZ ? y : z) * volume.w;
+            if (wantMIP) kernels.maxRow(&maxima[offset], row, volume.w);
+            if (wantMinIP) kernels.minRow(&minima[offset], row, volume.w);
+            if (!sums.empty()) kernels.sumRow(&sums[offset], row, volume.w);
+            if (wantStdDev) kernels.sumSquaresRow(&sumSquares[offset], row, volume.w);
+        });
+    }
+
+    if (wantMIP) results[projMIP] = std::move(maxima);
+    if (wantMinIP) results[projMinIP] = std::move(minima);
+    if (wantAIP) {
+        std::vector<unsigned char>& average = results[projAIP];
+        average.resize(pixels, 0);
+        for (size_t i = 0; i < pixels && n > 0; ++i) {
+            average[i] = static_cast<unsigned char>(sums[i] / n);
+        }
+    }
+    if (wantStdDev) {
+        std::vector<unsigned char>& deviation = results[projStdDev];
+        deviation.resize(pixels, 0);
+        for (size_t i = 0; i < pixels && n > 0; ++i) {
+            // n^2 * variance = n * sum(v^2) - sum(v)^2, exact in integers
+            uint64_t scaledVariance = n * sumSquares[i] - static_cast<uint64_t>(sums[i]) * sums[i];
+            deviation[i] = static_cast<unsigned char>(std::lround(std::sqrt(static_cast<double>(scaledVariance)) / n));
+        }
+    }
+    return results;
+}
+
+/**
+ * @brief Computes a MIP or MinIP along z together with its depth map.
+ *
+ * The depth map records, for every pixel, the slice at which the projected value was found, which is what a
+ * surface reconstruction needs and would otherwise take a second scan of the volume to recover. Each row is
+ * folded with the depth-tracking kernels, which update the running extreme and its slice index in one step.
+ * The slices of every output row are folded in increasing z, so ties resolve to the first slice reaching the
+ * extreme; a pixel that is 0 (MIP) or 255 (MinIP) throughout has depth 0.
+ *
+ * @param method projMIP or projMinIP.
+ * @param volume The volume to project; it is not modified.
+ * @param depth Receives the w * h map of 0-based slice indices.
+ * @return The w * h projection, the same image apply() produces.
+ */
+std::vector<unsigned char> Projection::applyWithDepth(Proj method, const Volume& volume, std::vector<uint16_t>& depth) {
+    if (method != projMIP && method != projMinIP) {
+        throw std::invalid_argument("depth maps are available for MIP and MinIP");
+    }
+    if (volume.l > UINT16_MAX + 1) {
+        throw std::invalid_argument("depth maps hold at most 65536 slices");
+    }
+    const ProjectionKernels& kernels = ProjectionKernels::active();
+    auto fold = method == projMIP ? kernels.maxRowWithDepth : kernels.minRowWithDepth;
+    size_t pixels = static_cast<size_t>(volume.w) * volume.h;
+    std::vector<unsigned char> result(pixels, method == projMIP ? 0 : 255);
+    depth.assign(pixels, 0);
+    forEachRow(volume, axisZ, [&](int y, int z, const unsigned char* row) {
+        size_t offset = static_cast<size_t>(y) * volume.w;
+        fold(&result[offset], &depth[offset], row, volume.w, static_cast<uint16_t>(z));
+    });
+    return result;
+}
+
+namespace {
+    /**
+     * One 256-bin histogram per pixel for a band of output rows. Counts are 16 bits wide while the volume has
+     * fewer than 65536 slices, which halves the memory each band needs.
+     */
+    template <typename Count>
+    struct PixelHistograms {
+        std::vector<Count> bins;
+        explicit PixelHistograms(size_t pixels) : bins(pixels * 256, 0) {}
+
+        void add(size_t pixel, const unsigned char* row, int w) {
+            Count* counts = bins.data() + pixel * 256;
+            for (int x = 0; x < w; ++x) {
+                ++counts[static_cast<size_t>(x) * 256 + row[x]];
+            }
+        }
+
+        /**
+         * Write the value at the fractional rank `position` of the sorted samples of pixels first .. last - 1,
+         * interpolating between the two ranks it falls between.
+         */
+        void select(size_t first, size_t last, double position, unsigned char* out) const {
+            uint32_t lower = static_cast<uint32_t>(position);
+            double fraction = position - lower;
+            for (size_t pixel = first; pixel < last; ++pixel) {
+                const Count* counts = bins.data() + pixel * 256;
+                uint32_t seen = 0;
+                int value = 0;
+                while ((seen += counts[value]) <= lower) {
+                    ++value;
+                }
+                int below = value;
+                if (fraction > 0.0 && seen == lower + 1) { // the next rank is in a later, non-empty bin
+                    do {
+                        ++value;
+                    } while (counts[value] == 0);
                 }
+                out[pixel] = static_cast<unsigned char>(std::lround(below + fraction * (value - below)));
             }
-            // Write minimum intensity value into result image
-            result[(y-1) * volume.w + x-1] = minIntensity;
         }
+    };
+
+    template <typename Count>
+    void percentileProjection(const Volume& volume, ThreadPool& workers, double position, unsigned char* out) {
+        size_t rowBytes = static_cast<size_t>(volume.w) * 256 * sizeof(Count);
+
+        if (!volume.isLazy()) {
+            // bands small enough that their histograms stay in cache while every slice streams through them
+            int bandRows = static_cast<int>(std::clamp<size_t>((1 << 20) / rowBytes, 1, volume.h));
+            int bands = (volume.h + bandRows - 1) / bandRows;
+            workers.parallelFor(0, bands, [&](int band) {
+                int first = band * bandRows;
+                int last = std::min(first + bandRows, volume.h);
+                PixelHistograms<Count> histograms(static_cast<size_t>(last - first) * volume.w);
+                for (int z = 0; z < volume.l; ++z) {
+                    for (int y = first; y < last; ++y) {
+                        histograms.add(static_cast<size_t>(y - first) * volume.w, volume.row(y, z), volume.w);
+                    }
+                }
+                histograms.select(0, histograms.bins.size() / 256, position, out + static_cast<size_t>(first) * volume.w);
+            });
+            return;
+        }
+
+        // a lazy volume is streamed once per group of rows, with only the calling thread touching its cache
+        int groupRows = static_cast<int>(std::clamp<size_t>((size_t(64) << 20) / rowBytes, 1, volume.h));
+        for (int group = 0; group < volume.h; group += groupRows) {
+            int rows = std::min(groupRows, volume.h - group);
+            int bands = std::min<int>(rows, workers.size() * 4);
+            PixelHistograms<Count> histograms(static_cast<size_t>(rows) * volume.w);
+            auto bandRange = [&](int band, int& first, int& last) {
+                first = static_cast<int>(static_cast<long long>(rows) * band / bands);
+                last = static_cast<int>(static_cast<long long>(rows) * (band + 1) / bands);
+            };
+            streamLazySlices(volume, workers, [&](int, const unsigned char* slice) {
+                workers.parallelFor(0, bands, [&](int band) {
+                    int first, last;
+                    bandRange(band, first, last);
+                    for (int y = first; y < last; ++y) {
+                        histograms.add(static_cast<size_t>(y) * volume.w, slice + (group + y) * volume.yStride, volume.w);
+                    }
+                });
+            });
+            workers.parallelFor(0, bands, [&](int band) {
+                int first, last;
+                bandRange(band, first, last);
+                histograms.select(static_cast<size_t>(first) * volume.w, static_cast<size_t>(last) * volume.w, position,
+                                  out + static_cast<size_t>(group) * volume.w);
+            });
+        }
+    }
+}
+
+/**
+ * @brief Computes a percentile intensity projection along z.
+ *
+ * Every pixel gets a 256-bin histogram of its intensities, filled in a single pass over the slices, and the
+ * percentile is then read off the cumulative counts instead of sorting each column. The output is split into
+ * bands of rows whose histograms fit in cache, and the bands are processed in parallel. A lazily loaded volume
+ * is streamed through its cache once per group of rows, sized so the histograms take at most 64 MB.
+ *
+ * The percentile p of the n values along a column is the value at rank p / 100 * (n - 1) of the sorted column,
+ * interpolated linearly between neighbouring ranks and rounded to the nearest intensity (halves round up). The
+ * median is p = 50, so an even column gives the rounded mean of its two middle values.
+ *
+ * @param percentile The percentile in [0, 100].
+ * @param volume The volume to project; it is not modified.
+ * @return The w * h projection.
+ */
+std::vector<unsigned char> Projection::applyPercentile(float percentile, const Volume& volume) {
+    if (!(percentile >= 0.0f && percentile <= 100.0f)) {
+        throw std::invalid_argument("percentile must be between 0 and 100");
+    }
+    std::vector<unsigned char> result(static_cast<size_t>(volume.w) * volume.h, 0);
+    if (result.empty() || volume.l <= 0) {
+        return result;
+    }
+    ThreadPool& workers = pool ? *pool : ThreadPool::shared();
+    double position = percentile / 100.0 * (volume.l - 1);
+    if (volume.l <= UINT16_MAX) {
+        percentileProjection<uint16_t>(volume, workers, position, result.data());
+    } else {
+        percentileProjection<uint32_t>(volume, workers, position, result.data());
     }
-    volume.slice = result;
+    return result;
 }
 
+/**
+ * The size of the image a projection along `axis` produces: w x h along z, w x l along y, h x l along x.
+ */
+void Projection::outputSize(const Volume& volume, Axis axis, int& width, int& height) {
+    width = axis == axisX ? volume.h : volume.w;
+    height = axis == axisZ ? volume.h : volume.l;
+}
 
-void Projection::apply(Proj method, Volume& volume) {
+
+/**
+ * Project the volume along `axis` and store the image in volume.slice. Projections along z use the dedicated
+ * MIP, MinIP and AIP routines; the other axes and the standard deviation projection go through applyFused,
+ * and the median through applyPercentile.
+ *
+ * @param method The projection method to apply.
+ * @param volume The volume to project; the image is stored in its slice, sized as given by outputSize.
+ * @param axis The axis to project along, z by default.
+ */
+void Projection::apply(Proj method, Volume& volume, Axis axis) {
+    if (axis != axisZ && method >= projMIP && method <= projAIP) {
+        volume.slice = std::move(applyFused({method}, volume, axis)[method]);
+        std::cout << "[LOG] Performing projection along " << (axis == axisX ? "x" : "y") << std::endl;
+        volume.sliced = true;
+        return;
+    }
     switch (method) {
         case Proj::projMIP:
             MIP(volume);
@@ -126,6 +461,18 @@ void Projection::apply(Proj method, Volume& volume) {
             AIP(volume);
             std::cout << "[LOG] Performing AIP" << std::endl;
             break;
+        case Proj::projStdDev:
+            volume.slice = std::move(applyFused({projStdDev}, volume, axis)[projStdDev]);
+            std::cout << "[LOG] Performing standard deviation projection" << std::endl;
+            break;
+        case Proj::projMedian:
+            if (axis != axisZ) {
+                std::cout << "[ERROR] The median projection is only available along z." << std::endl;
+                return;
+            }
+            volume.slice = applyPercentile(50.0f, volume);
+            std::cout << "[LOG] Performing median projection" << std::endl;
+            break;
         default:
             std::cout << "[ERROR] Invalid projection method specified." << std::endl;
             break;
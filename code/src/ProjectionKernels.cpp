@@ -0,0 +1,516 @@
+#include "ProjectionKernels.h"
+#include <algorithm>
+#include <atomic>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PROJECTION_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+    void maxRowScalar(unsigned char* out, const unsigned char* row, int w) {
+        for (int x = 0; x < w; ++x) {
+            out[x] = std::max(out[x], row[x]);
+        }
+    }
+
+    void minRowScalar(unsigned char* out, const unsigned char* row, int w) {
+        for (int x = 0; x < w; ++x) {
+            out[x] = std::min(out[x], row[x]);
+        }
+    }
+
+    void sumRowScalar(unsigned int* sum, const unsigned char* row, int w) {
+        for (int x = 0; x < w; ++x) {
+            sum[x] += row[x];
+        }
+    }
+
+    void sumSquaresRowScalar(uint64_t* sumSquares, const unsigned char* row, int w) {
+        for (int x = 0; x < w; ++x) {
+            sumSquares[x] += static_cast<unsigned int>(row[x]) * row[x];
+        }
+    }
+
+    unsigned char maxOfRowScalar(const unsigned char* row, int w) {
+        unsigned char result = 0;
+        for (int x = 0; x < w; ++x) {
+            result = std::max(result, row[x]);
+        }
+        return result;
+    }
+
+    unsigned char minOfRowScalar(const unsigned char* row, int w) {
+        unsigned char result = 255;
+        for (int x = 0; x < w; ++x) {
+            result = std::min(result, row[x]);
+        }
+        return result;
+    }
+
+    uint64_t sumOfRowScalar(const unsigned char* row, int w) {
+        uint64_t result = 0;
+        for (int x = 0; x < w; ++x) {
+            result += row[x];
+        }
+        return result;
+    }
+
+    uint64_t sumSquaresOfRowScalar(const unsigned char* row, int w) {
+        uint64_t result = 0;
+        for (int x = 0; x < w; ++x) {
+            result += static_cast<unsigned int>(row[x]) * row[x];
+        }
+        return result;
+    }
+
+    // The depth kernels keep the first slice at which the extreme was reached: a voxel only replaces the
+    // running extreme (and its depth) when it is strictly greater (smaller).
+    template <bool maximum>
+    void extremumRowWithDepthScalar(unsigned char* out, uint16_t* depth, const unsigned char* row, int w, uint16_t z) {
+        for (int x = 0; x < w; ++x) {
+            if (maximum ? row[x] > out[x] : row[x] < out[x]) {
+                out[x] = row[x];
+                depth[x] = z;
+            }
+        }
+    }
+
+#ifdef PROJECTION_KERNELS_X86
+    // SSE2: 16 voxels per step. Sums widen u8 -> u16 -> u32 (-> u64) by unpacking with zero.
+    __attribute__((target("sse2")))
+    void maxRowSSE2(unsigned char* out, const unsigned char* row, int w) {
+        int x = 0;
+        for (; x + 16 <= w; x += 16) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(out + x));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_max_epu8(a, b));
+        }
+        maxRowScalar(out + x, row + x, w - x);
+    }
+
+    __attribute__((target("sse2")))
+    void minRowSSE2(unsigned char* out, const unsigned char* row, int w) {
+        int x = 0;
+        for (; x + 16 <= w; x += 16) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(out + x));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_min_epu8(a, b));
+        }
+        minRowScalar(out + x, row + x, w - x);
+    }
+
+    __attribute__((target("sse2")))
+    void sumRowSSE2(unsigned int* sum, const unsigned char* row, int w) {
+        const __m128i zero = _mm_setzero_si128();
+        int x = 0;
+        for (; x + 16 <= w; x += 16) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+            __m128i words[2] = {_mm_unpacklo_epi8(bytes, zero), _mm_unpackhi_epi8(bytes, zero)};
+            for (int half = 0; half < 2; ++half) {
+                __m128i* lo = reinterpret_cast<__m128i*>(sum + x + half * 8);
+                __m128i* hi = reinterpret_cast<__m128i*>(sum + x + half * 8 + 4);
+                _mm_storeu_si128(lo, _mm_add_epi32(_mm_loadu_si128(lo), _mm_unpacklo_epi16(words[half], zero)));
+                _mm_storeu_si128(hi, _mm_add_epi32(_mm_loadu_si128(hi), _mm_unpackhi_epi16(words[half], zero)));
+            }
+        }
+        sumRowScalar(sum + x, row + x, w - x);
+    }
+
+    __attribute__((target("sse2")))
+    void sumSquaresRowSSE2(uint64_t* sumSquares, const unsigned char* row, int w) {
+        const __m128i zero = _mm_setzero_si128();
+        int x = 0;
+        for (; x + 8 <= w; x += 8) {
+            __m128i words = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + x)), zero);
+            __m128i squares = _mm_mullo_epi16(words, words); // 255 * 255 still fits in 16 bits
+            __m128i dwords[2] = {_mm_unpacklo_epi16(squares, zero), _mm_unpackhi_epi16(squares, zero)};
+            for (int half = 0; half < 2; ++half) {
+                __m128i* lo = reinterpret_cast<__m128i*>(sumSquares + x + half * 4);
+                __m128i* hi = reinterpret_cast<__m128i*>(sumSquares + x + half * 4 + 2);
+                _mm_storeu_si128(lo, _mm_add_epi64(_mm_loadu_si128(lo), _mm_unpacklo_epi32(dwords[half], zero)));
+                _mm_storeu_si128(hi, _mm_add_epi64(_mm_loadu_si128(hi), _mm_unpackhi_epi32(dwords[half], zero)));
+            }
+        }
+        sumSquaresRowScalar(sumSquares + x, row + x, w - x);
+    }
+
+    // Horizontal reductions keep a vector of partial results and fold it at the end: max/min lane-wise,
+    // sums with psadbw (eight bytes to one u64), squares with pmaddwd (pairs of u16 squares to one i32).
+    __attribute__((target("sse2")))
+    unsigned char maxOfRowSSE2(const unsigned char* row, int w) {
+        __m128i partial = _mm_setzero_si128();
+        int x = 0;
+        for (; x + 16 <= w; x += 16) {
+            partial = _mm_max_epu8(partial, _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x)));
+        }
+        alignas(16) unsigned char lanes[16];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), partial);
+        return std::max(maxOfRowScalar(lanes, 16), maxOfRowScalar(row + x, w - x));
+    }
+
+    __attribute__((target("sse2")))
+    unsigned char minOfRowSSE2(const unsigned char* row, int w) {
+        __m128i partial = _mm_set1_epi8(static_cast<char>(255));
+        int x = 0;
+        for (; x + 16 <= w; x += 16) {
+            partial = _mm_min_epu8(partial, _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x)));
+        }
+        alignas(16) unsigned char lanes[16];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), partial);
+        return std::min(minOfRowScalar(lanes, 16), minOfRowScalar(row + x, w - x));
+    }
+
+    __attribute__((target("sse2")))
+    uint64_t sumOfRowSSE2(const unsigned char* row, int w) {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i partial = zero;
+        int x = 0;
+        for (; x + 16 <= w; x += 16) {
+            partial = _mm_add_epi64(partial, _mm_sad_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x)), zero));
+        }
+        alignas(16) uint64_t lanes[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), partial);
+        return lanes[0] + lanes[1] + sumOfRowScalar(row + x, w - x);
+    }
+
+    __attribute__((target("sse2")))
+    uint64_t sumSquaresOfRowSSE2(const unsigned char* row, int w) {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i partial = zero;
+        int x = 0;
+        for (; x + 8 <= w; x += 8) {
+            __m128i words = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + x)), zero);
+            __m128i pairs = _mm_madd_epi16(words, words); // at most 2 * 255^2 per lane, so never negative
+            partial = _mm_add_epi64(partial, _mm_add_epi64(_mm_unpacklo_epi32(pairs, zero), _mm_unpackhi_epi32(pairs, zero)));
+        }
+        alignas(16) uint64_t lanes[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), partial);
+        return lanes[0] + lanes[1] + sumSquaresOfRowScalar(row + x, w - x);
+    }
+
+    // Lanes whose extreme changed are those where max(out, row) differs from out; the byte mask is widened
+    // to 16 bits by unpacking it with itself and used to select z into the depth row. Steps where no lane
+    // changed, the common case once the extreme has settled, skip the depth row entirely.
+    template <bool maximum>
+    __attribute__((target("sse2")))
+    void extremumRowWithDepthSSE2(unsigned char* out, uint16_t* depth, const unsigned char* row, int w, uint16_t z) {
+        const __m128i slice = _mm_set1_epi16(static_cast<short>(z));
+        int x = 0;
+        for (; x + 16 <= w; x += 16) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(out + x));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+            __m128i extreme = maximum ? _mm_max_epu8(a, b) : _mm_min_epu8(a, b);
+            __m128i changed = _mm_xor_si128(_mm_cmpeq_epi8(extreme, a), _mm_set1_epi8(-1));
+            if (_mm_movemask_epi8(changed) == 0) {
+                continue;
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), extreme);
+            __m128i masks[2] = {_mm_unpacklo_epi8(changed, changed), _mm_unpackhi_epi8(changed, changed)};
+            for (int half = 0; half < 2; ++half) {
+                __m128i* target = reinterpret_cast<__m128i*>(depth + x + half * 8);
+                __m128i old = _mm_loadu_si128(target);
+                _mm_storeu_si128(target, _mm_or_si128(_mm_and_si128(masks[half], slice), _mm_andnot_si128(masks[half], old)));
+            }
+        }
+        extremumRowWithDepthScalar<maximum>(out + x, depth + x, row + x, w - x, z);
+    }
+
+    // AVX2: 32 voxels per step for max/min, zero-extending loads for the sums.
+    __attribute__((target("avx2")))
+    void maxRowAVX2(unsigned char* out, const unsigned char* row, int w) {
+        int x = 0;
+        for (; x + 32 <= w; x += 32) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(out + x));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), _mm256_max_epu8(a, b));
+        }
+        maxRowScalar(out + x, row + x, w - x);
+    }
+
+    __attribute__((target("avx2")))
+    void minRowAVX2(unsigned char* out, const unsigned char* row, int w) {
+        int x = 0;
+        for (; x + 32 <= w; x += 32) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(out + x));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), _mm256_min_epu8(a, b));
+        }
+        minRowScalar(out + x, row + x, w - x);
+    }
+
+    __attribute__((target("avx2")))
+    void sumRowAVX2(unsigned int* sum, const unsigned char* row, int w) {
+        int x = 0;
+        for (; x + 8 <= w; x += 8) {
+            __m256i values = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + x)));
+            __m256i* target = reinterpret_cast<__m256i*>(sum + x);
+            _mm256_storeu_si256(target, _mm256_add_epi32(_mm256_loadu_si256(target), values));
+        }
+        sumRowScalar(sum + x, row + x, w - x);
+    }
+
+    __attribute__((target("avx2")))
+    void sumSquaresRowAVX2(uint64_t* sumSquares, const unsigned char* row, int w) {
+        int x = 0;
+        for (; x + 8 <= w; x += 8) {
+            __m128i words = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + x)));
+            __m128i squares = _mm_mullo_epi16(words, words);
+            __m256i* lo = reinterpret_cast<__m256i*>(sumSquares + x);
+            __m256i* hi = reinterpret_cast<__m256i*>(sumSquares + x + 4);
+            _mm256_storeu_si256(lo, _mm256_add_epi64(_mm256_loadu_si256(lo), _mm256_cvtepu16_epi64(squares)));
+            _mm256_storeu_si256(hi, _mm256_add_epi64(_mm256_loadu_si256(hi), _mm256_cvtepu16_epi64(_mm_srli_si128(squares, 8))));
+        }
+        sumSquaresRowScalar(sumSquares + x, row + x, w - x);
+    }
+
+    __attribute__((target("avx2")))
+    unsigned char maxOfRowAVX2(const unsigned char* row, int w) {
+        __m256i partial = _mm256_setzero_si256();
+        int x = 0;
+        for (; x + 32 <= w; x += 32) {
+            partial = _mm256_max_epu8(partial, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x)));
+        }
+        alignas(32) unsigned char lanes[32];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), partial);
+        return std::max(maxOfRowScalar(lanes, 32), maxOfRowScalar(row + x, w - x));
+    }
+
+    __attribute__((target("avx2")))
+    unsigned char minOfRowAVX2(const unsigned char* row, int w) {
+        __m256i partial = _mm256_set1_epi8(static_cast<char>(255));
+        int x = 0;
+        for (; x + 32 <= w; x += 32) {
+            partial = _mm256_min_epu8(partial, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x)));
+        }
+        alignas(32) unsigned char lanes[32];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), partial);
+        return std::min(minOfRowScalar(lanes, 32), minOfRowScalar(row + x, w - x));
+    }
+
+    __attribute__((target("avx2")))
+    uint64_t sumOfRowAVX2(const unsigned char* row, int w) {
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i partial = zero;
+        int x = 0;
+        for (; x + 32 <= w; x += 32) {
+            partial = _mm256_add_epi64(partial, _mm256_sad_epu8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x)), zero));
+        }
+        alignas(32) uint64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), partial);
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sumOfRowScalar(row + x, w - x);
+    }
+
+    __attribute__((target("avx2")))
+    uint64_t sumSquaresOfRowAVX2(const unsigned char* row, int w) {
+        __m256i partial = _mm256_setzero_si256();
+        int x = 0;
+        for (; x + 16 <= w; x += 16) {
+            __m256i words = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x)));
+            __m256i pairs = _mm256_madd_epi16(words, words);
+            partial = _mm256_add_epi64(partial, _mm256_add_epi64(_mm256_cvtepu32_epi64(_mm256_castsi256_si128(pairs)),
+                                                                 _mm256_cvtepu32_epi64(_mm256_extracti128_si256(pairs, 1))));
+        }
+        alignas(32) uint64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), partial);
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sumSquaresOfRowScalar(row + x, w - x);
+    }
+
+    template <bool maximum>
+    __attribute__((target("avx2")))
+    void extremumRowWithDepthAVX2(unsigned char* out, uint16_t* depth, const unsigned char* row, int w, uint16_t z) {
+        const __m256i slice = _mm256_set1_epi16(static_cast<short>(z));
+        int x = 0;
+        for (; x + 32 <= w; x += 32) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(out + x));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x));
+            __m256i extreme = maximum ? _mm256_max_epu8(a, b) : _mm256_min_epu8(a, b);
+            __m256i changed = _mm256_xor_si256(_mm256_cmpeq_epi8(extreme, a), _mm256_set1_epi8(-1));
+            if (_mm256_movemask_epi8(changed) == 0) {
+                continue;
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), extreme);
+            // sign extension turns each 0xFF byte of the mask into a 0xFFFF word, in lane order
+            __m256i masks[2] = {_mm256_cvtepi8_epi16(_mm256_castsi256_si128(changed)), _mm256_cvtepi8_epi16(_mm256_extracti128_si256(changed, 1))};
+            for (int half = 0; half < 2; ++half) {
+                __m256i* target = reinterpret_cast<__m256i*>(depth + x + half * 16);
+                _mm256_storeu_si256(target, _mm256_blendv_epi8(_mm256_loadu_si256(target), slice, masks[half]));
+            }
+        }
+        extremumRowWithDepthScalar<maximum>(out + x, depth + x, row + x, w - x, z);
+    }
+
+    // AVX-512 (F + BW): 64 voxels per step for max/min, 16 or 8 widened lanes for the sums. The zero-masked
+    // conversions avoid GCC 12's spurious -Wmaybe-uninitialized on the unmasked ones.
+    __attribute__((target("avx512f,avx512bw")))
+    void maxRowAVX512(unsigned char* out, const unsigned char* row, int w) {
+        int x = 0;
+        for (; x + 64 <= w; x += 64) {
+            __m512i a = _mm512_loadu_si512(out + x);
+            __m512i b = _mm512_loadu_si512(row + x);
+            _mm512_storeu_si512(out + x, _mm512_max_epu8(a, b));
+        }
+        maxRowScalar(out + x, row + x, w - x);
+    }
+
+    __attribute__((target("avx512f,avx512bw")))
+    void minRowAVX512(unsigned char* out, const unsigned char* row, int w) {
+        int x = 0;
+        for (; x + 64 <= w; x += 64) {
+            __m512i a = _mm512_loadu_si512(out + x);
+            __m512i b = _mm512_loadu_si512(row + x);
+            _mm512_storeu_si512(out + x, _mm512_min_epu8(a, b));
+        }
+        minRowScalar(out + x, row + x, w - x);
+    }
+
+    __attribute__((target("avx512f,avx512bw")))
+    void sumRowAVX512(unsigned int* sum, const unsigned char* row, int w) {
+        int x = 0;
+        for (; x + 16 <= w; x += 16) {
+            __m512i values = _mm512_maskz_cvtepu8_epi32(0xFFFF, _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x)));
+            _mm512_storeu_si512(sum + x, _mm512_add_epi32(_mm512_loadu_si512(sum + x), values));
+        }
+        sumRowScalar(sum + x, row + x, w - x);
+    }
+
+    __attribute__((target("avx512f,avx512bw")))
+    void sumSquaresRowAVX512(uint64_t* sumSquares, const unsigned char* row, int w) {
+        int x = 0;
+        for (; x + 8 <= w; x += 8) {
+            __m128i words = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + x)));
+            __m512i squares = _mm512_maskz_cvtepu16_epi64(0xFF, _mm_mullo_epi16(words, words));
+            _mm512_storeu_si512(sumSquares + x, _mm512_add_epi64(_mm512_loadu_si512(sumSquares + x), squares));
+        }
+        sumSquaresRowScalar(sumSquares + x, row + x, w - x);
+    }
+
+    __attribute__((target("avx512f,avx512bw")))
+    unsigned char maxOfRowAVX512(const unsigned char* row, int w) {
+        __m512i partial = _mm512_setzero_si512();
+        int x = 0;
+        for (; x + 64 <= w; x += 64) {
+            partial = _mm512_max_epu8(partial, _mm512_loadu_si512(row + x));
+        }
+        alignas(64) unsigned char lanes[64];
+        _mm512_store_si512(lanes, partial);
+        return std::max(maxOfRowScalar(lanes, 64), maxOfRowScalar(row + x, w - x));
+    }
+
+    __attribute__((target("avx512f,avx512bw")))
+    unsigned char minOfRowAVX512(const unsigned char* row, int w) {
+        __m512i partial = _mm512_set1_epi8(static_cast<char>(255));
+        int x = 0;
+        for (; x + 64 <= w; x += 64) {
+            partial = _mm512_min_epu8(partial, _mm512_loadu_si512(row + x));
+        }
+        alignas(64) unsigned char lanes[64];
+        _mm512_store_si512(lanes, partial);
+        return std::min(minOfRowScalar(lanes, 64), minOfRowScalar(row + x, w - x));
+    }
+
+    __attribute__((target("avx512f,avx512bw")))
+    uint64_t sumOfRowAVX512(const unsigned char* row, int w) {
+        const __m512i zero = _mm512_setzero_si512();
+        __m512i partial = zero;
+        int x = 0;
+        for (; x + 64 <= w; x += 64) {
+            partial = _mm512_add_epi64(partial, _mm512_sad_epu8(_mm512_loadu_si512(row + x), zero));
+        }
+        alignas(64) uint64_t lanes[8];
+        _mm512_store_si512(lanes, partial);
+        return sumOfRowScalar(row + x, w - x) + lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7];
+    }
+
+    __attribute__((target("avx512f,avx512bw")))
+    uint64_t sumSquaresOfRowAVX512(const unsigned char* row, int w) {
+        const __m512i zero = _mm512_setzero_si512();
+        __m512i partial = zero;
+        int x = 0;
+        for (; x + 32 <= w; x += 32) {
+            __m512i words = _mm512_maskz_cvtepu8_epi16(0xFFFFFFFF, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x)));
+            __m512i pairs = _mm512_madd_epi16(words, words);
+            partial = _mm512_add_epi64(partial, _mm512_add_epi64(_mm512_maskz_unpacklo_epi32(0xFFFF, pairs, zero), _mm512_maskz_unpackhi_epi32(0xFFFF, pairs, zero)));
+        }
+        alignas(64) uint64_t lanes[8];
+        _mm512_store_si512(lanes, partial);
+        return sumSquaresOfRowScalar(row + x, w - x) + lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7];
+    }
+
+    template <bool maximum>
+    __attribute__((target("avx512f,avx512bw")))
+    void extremumRowWithDepthAVX512(unsigned char* out, uint16_t* depth, const unsigned char* row, int w, uint16_t z) {
+        const __m512i slice = _mm512_set1_epi16(static_cast<short>(z));
+        int x = 0;
+        for (; x + 64 <= w; x += 64) {
+            __m512i a = _mm512_loadu_si512(out + x);
+            __m512i b = _mm512_loadu_si512(row + x);
+            __mmask64 changed = maximum ? _mm512_cmpgt_epu8_mask(b, a) : _mm512_cmplt_epu8_mask(b, a);
+            if (changed == 0) {
+                continue;
+            }
+            _mm512_storeu_si512(out + x, _mm512_mask_mov_epi8(a, changed, b));
+            _mm512_mask_storeu_epi16(depth + x, static_cast<__mmask32>(changed), slice);
+            _mm512_mask_storeu_epi16(depth + x + 32, static_cast<__mmask32>(changed >> 32), slice);
+        }
+        extremumRowWithDepthScalar<maximum>(out + x, depth + x, row + x, w - x, z);
+    }
+#endif
+
+    const ProjectionKernels kernelTable[] = {
+        {maxRowScalar, minRowScalar, sumRowScalar, sumSquaresRowScalar,
+         maxOfRowScalar, minOfRowScalar, sumOfRowScalar, sumSquaresOfRowScalar,
+         extremumRowWithDepthScalar<true>, extremumRowWithDepthScalar<false>},
+#ifdef PROJECTION_KERNELS_X86
+        {maxRowSSE2, minRowSSE2, sumRowSSE2, sumSquaresRowSSE2,
+         maxOfRowSSE2, minOfRowSSE2, sumOfRowSSE2, sumSquaresOfRowSSE2,
+         extremumRowWithDepthSSE2<true>, extremumRowWithDepthSSE2<false>},
+        {maxRowAVX2, minRowAVX2, sumRowAVX2, sumSquaresRowAVX2,
+         maxOfRowAVX2, minOfRowAVX2, sumOfRowAVX2, sumSquaresOfRowAVX2,
+         extremumRowWithDepthAVX2<true>, extremumRowWithDepthAVX2<false>},
+        {maxRowAVX512, minRowAVX512, sumRowAVX512, sumSquaresRowAVX512,
+         maxOfRowAVX512, minOfRowAVX512, sumOfRowAVX512, sumSquaresOfRowAVX512,
+         extremumRowWithDepthAVX512<true>, extremumRowWithDepthAVX512<false>},
+#endif
+    };
+
+    /**
+     * The widest instruction set this CPU supports, up to `limit`.
+     */
+    ProjectionKernels::Isa supportedIsa(ProjectionKernels::Isa limit) {
+#ifdef PROJECTION_KERNELS_X86
+        __builtin_cpu_init();
+        if (limit >= ProjectionKernels::AVX512 && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+            return ProjectionKernels::AVX512;
+        }
+        if (limit >= ProjectionKernels::AVX2 && __builtin_cpu_supports("avx2")) {
+            return ProjectionKernels::AVX2;
+        }
+        if (limit >= ProjectionKernels::SSE2 && __builtin_cpu_supports("sse2")) {
+            return ProjectionKernels::SSE2;
+        }
+#else
+        (void)limit;
+#endif
+        return ProjectionKernels::Scalar;
+    }
+
+    std::atomic<int>& currentIsa() {
+        static std::atomic<int> isa{supportedIsa(ProjectionKernels::AVX512)};
+        return isa;
+    }
+}
+
+const ProjectionKernels& ProjectionKernels::active() {
+    return kernelTable[currentIsa().load(std::memory_order_relaxed)];
+}
+
+ProjectionKernels::Isa ProjectionKernels::activeIsa() {
+    return static_cast<Isa>(currentIsa().load(std::memory_order_relaxed));
+}
+
+ProjectionKernels::Isa ProjectionKernels::select(Isa isa) {
+    Isa chosen = supportedIsa(isa);
+    currentIsa().store(chosen, std::memory_order_relaxed);
+    return chosen;
+}
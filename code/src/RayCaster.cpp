@@ -0,0 +1,252 @@
+#include "RayCaster.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+Rotation Rotation::identity() {
+    return {{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}};
+}
+
+Rotation Rotation::about(Projection::Axis axis, float degrees) {
+    float radians = degrees * static_cast<float>(M_PI) / 180.0f;
+    float c = std::cos(radians);
+    float s = std::sin(radians);
+    switch (axis) {
+        case Projection::axisX:
+            return {{{1, 0, 0}, {0, c, -s}, {0, s, c}}};
+        case Projection::axisY:
+            return {{{c, 0, s}, {0, 1, 0}, {-s, 0, c}}};
+        default:
+            return {{{c, -s, 0}, {s, c, 0}, {0, 0, 1}}};
+    }
+}
+
+Rotation Rotation::operator*(const Rotation& other) const {
+    Rotation result{};
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            for (int k = 0; k < 3; ++k) {
+                result.m[i][j] += m[i][k] * other.m[k][j];
+            }
+        }
+    }
+    return result;
+}
+
+namespace {
+    /**
+     * Reads voxels straight from the voxel buffer of an in-memory or memory-mapped volume.
+     */
+    struct DirectVoxels {
+        const unsigned char* data;
+        size_t xStride, yStride, zStride;
+        explicit DirectVoxels(const Volume& volume)
+            : data(volume.data.data()), xStride(volume.xStride), yStride(volume.yStride), zStride(volume.zStride) {}
+        float operator()(int x, int y, int z) const { return data[z * zStride + y * yStride + x * xStride]; }
+    };
+
+    /**
+     * Reads voxels through the accessors, for lazily loaded volumes.
+     */
+    struct CachedVoxels {
+        const Volume& volume;
+        float operator()(int x, int y, int z) const { return volume.at(x, y, z); }
+    };
+
+    /**
+     * Split a continuous coordinate into the lower of the two voxels to blend and the weight of the upper one.
+     */
+    inline void cell(float position, int size, int& lower, int& upper, float& weight) {
+        position = std::clamp(position, 0.0f, static_cast<float>(size - 1));
+        lower = std::min(static_cast<int>(position), std::max(size - 2, 0));
+        upper = std::min(lower + 1, size - 1);
+        weight = position - lower;
+    }
+
+    template <typename Voxels>
+    float trilinear(const Voxels& voxels, const Volume& volume, float x, float y, float z) {
+        int x0, x1, y0, y1, z0, z1;
+        float fx, fy, fz;
+        cell(x, volume.w, x0, x1, fx);
+        cell(y, volume.h, y0, y1, fy);
+        cell(z, volume.l, z0, z1, fz);
+        float c00 = voxels(x0, y0, z0) + fx * (voxels(x1, y0, z0) - voxels(x0, y0, z0));
+        float c10 = voxels(x0, y1, z0) + fx * (voxels(x1, y1, z0) - voxels(x0, y1, z0));
+        float c01 = voxels(x0, y0, z1) + fx * (voxels(x1, y0, z1) - voxels(x0, y0, z1));
+        float c11 = voxels(x0, y1, z1) + fx * (voxels(x1, y1, z1) - voxels(x0, y1, z1));
+        float c0 = c00 + fy * (c10 - c00);
+        float c1 = c01 + fy * (c11 - c01);
+        return c0 + fz * (c1 - c0);
+    }
+
+    /**
+     * Everything a ray needs that is the same for every pixel of a view, in physical units.
+     */
+    struct ViewGeometry {
+        float centre[3], extent[3], spacing[3];
+        float right[3], down[3], forward[3];
+        float pixel, stride;
+    };
+
+    /**
+     * Cast the ray through pixel (i, j) and reduce its samples.
+     */
+    template <typename Voxels>
+    unsigned char castRay(const Voxels& voxels, const Volume& volume, const ViewGeometry& view, Projection::Proj method,
+                          int i, int j, int width, int height) {
+        float origin[3];
+        float du = (i - (width - 1) * 0.5f) * view.pixel;
+        float dv = (j - (height - 1) * 0.5f) * view.pixel;
+        for (int a = 0; a < 3; ++a) {
+            origin[a] = view.centre[a] + du * view.right[a] + dv * view.down[a];
+        }
+
+        // clip the ray to the bounding box of the voxel centres, with a little slack for rounding
+        float enter = -std::numeric_limits<float>::infinity();
+        float exit = std::numeric_limits<float>::infinity();
+        float slack = 1e-4f * view.stride;
+        for (int a = 0; a < 3; ++a) {
+            if (std::fabs(view.forward[a]) < 1e-8f) {
+                if (origin[a] < -slack || origin[a] > view.extent[a] + slack) {
+                    return 0;
+                }
+                continue;
+            }
+            float t0 = (-slack - origin[a]) / view.forward[a];
+            float t1 = (view.extent[a] + slack - origin[a]) / view.forward[a];
+            enter = std::max(enter, std::min(t0, t1));
+            exit = std::min(exit, std::max(t0, t1));
+        }
+        if (enter > exit) {
+            return 0;
+        }
+
+        // start on the first whole step inside the box, so an axis-aligned view samples voxel centres
+        float first = std::ceil(enter / view.stride - 1e-3f) * view.stride;
+        float start[3], delta[3];
+        for (int a = 0; a < 3; ++a) {
+            start[a] = (origin[a] + first * view.forward[a]) / view.spacing[a];
+            delta[a] = view.stride * view.forward[a] / view.spacing[a];
+        }
+        int samples = static_cast<int>(std::floor((exit - first) / view.stride + 1e-3f)) + 1;
+
+        float maximum = 0.0f, minimum = 255.0f, sum = 0.0f;
+        int taken = 0;
+        for (int k = 0; k < samples; ++k) {
+            float value = trilinear(voxels, volume, start[0] + k * delta[0], start[1] + k * delta[1], start[2] + k * delta[2]);
+            ++taken;
+            if (method == Projection::projMIP) {
+                maximum = std::max(maximum, value);
+                if (maximum >= 254.5f) {
+                    break; // already rounds to 255, nothing later can change it
+                }
+            } else if (method == Projection::projMinIP) {
+                minimum = std::min(minimum, value);
+                if (minimum < 0.5f) {
+                    break;
+                }
+            } else {
+                sum += value;
+            }
+        }
+        if (taken == 0) {
+            return 0;
+        }
+        float result = method == Projection::projMIP ? maximum : (method == Projection::projMinIP ? minimum : sum / taken);
+        return static_cast<unsigned char>(std::lround(std::clamp(result, 0.0f, 255.0f)));
+    }
+}
+
+/**
+ * Create a ray caster producing width x height images.
+ *
+ * @param width The width of the rendered images.
+ * @param height The height of the rendered images.
+ * @param step The sampling step along each ray, in voxels of the finest spacing.
+ * @param threads The number of threads to render with; 0 uses the process-wide pool.
+ */
+RayCaster::RayCaster(int width, int height, float step, unsigned threads) : width(width), height(height), step(step) {
+    if (width <= 0 || height <= 0 || !(step > 0.0f)) {
+        throw std::invalid_argument("ray caster needs a positive image size and sampling step");
+    }
+    if (threads > 0) {
+        pool = std::make_shared<ThreadPool>(threads);
+    }
+}
+
+/**
+ * Render a MIP, MinIP or AIP view of the volume.
+ *
+ * @param method The projection to compute along each ray.
+ * @param volume The volume to render.
+ * @param view The rotation of the viewing direction; the identity looks down z.
+ * @return The rendered width * height image.
+ */
+std::vector<unsigned char> RayCaster::render(Projection::Proj method, const Volume& volume, const Rotation& view) const {
+    if (method != Projection::projMIP && method != Projection::projMinIP && method != Projection::projAIP) {
+        throw std::invalid_argument("ray casting supports MIP, MinIP and AIP");
+    }
+    std::vector<unsigned char> image(static_cast<size_t>(width) * height, 0);
+    if (volume.w <= 0 || volume.h <= 0 || volume.l <= 0) {
+        return image;
+    }
+
+    ViewGeometry geometry;
+    int dims[3] = {volume.w, volume.h, volume.l};
+    float unit = std::min({volume.spacing[0], volume.spacing[1], volume.spacing[2]});
+    float diagonal = 0.0f;
+    for (int a = 0; a < 3; ++a) {
+        geometry.spacing[a] = volume.spacing[a];
+        geometry.extent[a] = (dims[a] - 1) * volume.spacing[a];
+        geometry.centre[a] = geometry.extent[a] * 0.5f;
+        geometry.right[a] = view.m[a][0];
+        geometry.down[a] = view.m[a][1];
+        geometry.forward[a] = view.m[a][2];
+        diagonal += geometry.extent[a] * geometry.extent[a];
+    }
+    diagonal = std::max(std::sqrt(diagonal), unit);
+    geometry.stride = step * unit;
+    geometry.pixel = pixelSize > 0.0f ? pixelSize * unit : diagonal / std::min(width, height);
+
+    auto renderRows = [&](const auto& voxels, ThreadPool& workers, int bands) {
+        workers.parallelFor(0, bands, [&](int band) {
+            int first = static_cast<int>(static_cast<long long>(height) * band / bands);
+            int last = static_cast<int>(static_cast<long long>(height) * (band + 1) / bands);
+            for (int j = first; j < last; ++j) {
+                for (int i = 0; i < width; ++i) {
+                    image[static_cast<size_t>(j) * width + i] = castRay(voxels, volume, geometry, method, i, j, width, height);
+                }
+            }
+        });
+    };
+    ThreadPool& workers = pool ? *pool : ThreadPool::shared();
+    if (volume.isLazy()) {
+        renderRows(CachedVoxels{volume}, workers, 1);
+    } else {
+        renderRows(DirectVoxels(volume), workers, std::min<int>(height, workers.size() * 4));
+    }
+    return image;
+}
+
+/**
+ * Render a full revolution of the volume, e.g. for a rotating MIP movie.
+ *
+ * @param method The projection to compute along each ray.
+ * @param volume The volume to render.
+ * @param frames The number of frames; frame k is turned 360 * k / frames degrees.
+ * @param axis The axis of the volume to turn about.
+ * @param base A rotation applied before turning, e.g. to tilt the view.
+ * @return The rendered frames in order.
+ */
+std::vector<std::vector<unsigned char>> RayCaster::renderRotation(Projection::Proj method, const Volume& volume, int frames,
+                                                                  Projection::Axis axis, const Rotation& base) const {
+    std::vector<std::vector<unsigned char>> sequence;
+    sequence.reserve(std::max(frames, 0));
+    for (int frame = 0; frame < frames; ++frame) {
+        sequence.push_back(render(method, volume, Rotation::about(axis, 360.0f * frame / frames) * base));
+    }
+    std::cout << "[LOG] Rendered " << frames << " frame rotation." << std::endl;
+    return sequence;
+}
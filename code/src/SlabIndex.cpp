@@ -0,0 +1,238 @@
+#include "SlabIndex.h"
+#include "ProjectionKernels.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    /**
+     * Call rowTask(y, row) for every row of slice z, split into bands of rows across the shared pool. The
+     * slice is fetched once by the calling thread, so this is also safe for lazily loaded volumes.
+     */
+    template <typename RowTask>
+    void forSliceRows(const Volume& volume, int z, RowTask rowTask) {
+        ThreadPool& pool = ThreadPool::shared();
+        int bands = std::min<int>(volume.h, pool.size() * 4);
+        const unsigned char* slice = volume.slicePtr(z);
+        pool.parallelFor(0, bands, [&](int band) {
+            int first = static_cast<int>(static_cast<long long>(volume.h) * band / bands);
+            int last = static_cast<int>(static_cast<long long>(volume.h) * (band + 1) / bands);
+            for (int y = first; y < last; ++y) {
+                rowTask(y, slice + y * volume.yStride);
+            }
+        });
+    }
+}
+
+/**
+ * Build the slab structures for the requested methods in one or two passes over the volume.
+ *
+ * @param volume The volume to index; it must outlive the index.
+ * @param methods The projections to support: any of projMIP, projMinIP and projAIP.
+ * @param blockSize The number of slices per block. Smaller blocks make slabs within one block cheaper
+ *                  and the block table larger.
+ */
+SlabIndex::SlabIndex(const Volume& volume, const std::vector<Projection::Proj>& methods, int blockSize)
+    : w(volume.w), h(volume.h), l(volume.l), blockSize(std::max(blockSize, 1)), volume(volume),
+      sumBlockSize(std::min(this->blockSize, 65535 / 255)) {
+    planeBytes = static_cast<size_t>(w) * h;
+    blocks = (l + this->blockSize - 1) / this->blockSize;
+    auto wants = [&](Projection::Proj method) { return std::find(methods.begin(), methods.end(), method) != methods.end(); };
+    if (wants(Projection::projMIP)) {
+        buildExtremum(maxima, true);
+    }
+    if (wants(Projection::projMinIP)) {
+        buildExtremum(minima, false);
+    }
+    if (wants(Projection::projAIP)) {
+        buildPrefixSums();
+    }
+    std::cout << "[LOG] Slab index built for " << w << " x " << h << " x " << l << " with blocks of " << this->blockSize << " slices." << std::endl;
+}
+
+/**
+ * Fill the per-block running extremes and the block sparse table. Each block is walked forwards for the
+ * prefix planes and then backwards for the suffix planes, so a lazy volume only needs a block of slices
+ * in its cache to decode every slice once.
+ */
+void SlabIndex::buildExtremum(ExtremumIndex& index, bool maximum) {
+    const ProjectionKernels& kernels = ProjectionKernels::active();
+    auto fold = maximum ? kernels.maxRow : kernels.minRow;
+    index.prefix = VoxelBuffer(l * planeBytes);
+    index.suffix = VoxelBuffer(l * planeBytes);
+
+    for (int block = 0; block < blocks; ++block) {
+        int start = block * blockSize;
+        int end = std::min(start + blockSize, l) - 1;
+        for (int z = start; z <= end; ++z) {
+            unsigned char* plane = index.prefix.data() + z * planeBytes;
+            forSliceRows(volume, z, [&](int y, const unsigned char* row) {
+                unsigned char* out = plane + static_cast<size_t>(y) * w;
+                if (z == start) {
+                    std::memcpy(out, row, w);
+                } else {
+                    std::memcpy(out, out - planeBytes, w);
+                    fold(out, row, w);
+                }
+            });
+        }
+        for (int z = end; z >= start; --z) {
+            unsigned char* plane = index.suffix.data() + z * planeBytes;
+            forSliceRows(volume, z, [&](int y, const unsigned char* row) {
+                unsigned char* out = plane + static_cast<size_t>(y) * w;
+                if (z == end) {
+                    std::memcpy(out, row, w);
+                } else {
+                    std::memcpy(out, out + planeBytes, w);
+                    fold(out, row, w);
+                }
+            });
+        }
+    }
+
+    // runs of 2^k blocks; a run of one block is the suffix plane at the block's first slice
+    index.runs.clear();
+    for (int span = 2; span <= blocks; span *= 2) {
+        int count = blocks - span + 1;
+        VoxelBuffer level(count * planeBytes);
+        for (int block = 0; block < count; ++block) {
+            const unsigned char* left = span == 2 ? index.suffix.data() + block * blockSize * planeBytes
+                                                  : index.runs.back().data() + block * planeBytes;
+            const unsigned char* right = span == 2 ? index.suffix.data() + (block + 1) * blockSize * planeBytes
+                                                   : index.runs.back().data() + (block + span / 2) * planeBytes;
+            unsigned char* out = level.data() + block * planeBytes;
+            std::memcpy(out, left, planeBytes);
+            fold(out, right, static_cast<int>(planeBytes));
+        }
+        index.runs.push_back(std::move(level));
+    }
+    index.built = true;
+}
+
+/**
+ * Fill the block sums and in-block offsets used for slab averages. The sum before a block is the sum before
+ * the previous block plus the offset of that block's last slice.
+ */
+void SlabIndex::buildPrefixSums() {
+    int sumBlocks = (l + sumBlockSize - 1) / sumBlockSize;
+    blockSums.assign(sumBlocks * planeBytes, 0);
+    blockOffsets.assign(l * planeBytes, 0);
+    for (int z = 0; z < l; ++z) {
+        bool blockStart = z % sumBlockSize == 0;
+        uint16_t* plane = blockOffsets.data() + z * planeBytes;
+        uint32_t* sums = blockSums.data() + (z / sumBlockSize) * planeBytes;
+        forSliceRows(volume, z, [&](int y, const unsigned char* row) {
+            size_t offset = static_cast<size_t>(y) * w;
+            uint16_t* out = plane + offset;
+            if (blockStart) {
+                if (z > 0) {
+                    const uint32_t* previous = sums + offset - planeBytes;
+                    const uint16_t* last = out - planeBytes;
+                    for (int x = 0; x < w; ++x) {
+                        sums[offset + x] = previous[x] + last[x];
+                    }
+                }
+                std::copy_n(row, w, out);
+            } else {
+                const uint16_t* before = out - planeBytes;
+                for (int x = 0; x < w; ++x) {
+                    out[x] = static_cast<uint16_t>(before[x] + row[x]);
+                }
+            }
+        });
+    }
+}
+
+/**
+ * Combine the precomputed planes covering slices first .. last (0-based, inclusive) into `out`.
+ */
+void SlabIndex::projectExtremum(const ExtremumIndex& index, bool maximum, int first, int last, unsigned char* out) const {
+    const ProjectionKernels& kernels = ProjectionKernels::active();
+    auto fold = maximum ? kernels.maxRow : kernels.minRow;
+    int firstBlock = first / blockSize;
+    int lastBlock = last / blockSize;
+
+    if (firstBlock == lastBlock) { // short slab inside one block: reduce the slices directly
+        for (int z = first; z <= last; ++z) {
+            for (int y = 0; y < h; ++y) {
+                unsigned char* row = out + static_cast<size_t>(y) * w;
+                if (z == first) {
+                    std::memcpy(row, volume.row(y, z), w);
+                } else {
+                    fold(row, volume.row(y, z), w);
+                }
+            }
+        }
+        return;
+    }
+
+    int pixels = static_cast<int>(planeBytes);
+    std::memcpy(out, index.suffix.data() + first * planeBytes, planeBytes);
+    fold(out, index.prefix.data() + last * planeBytes, pixels);
+    int innerFirst = firstBlock + 1;
+    int innerLast = lastBlock - 1;
+    if (innerFirst <= innerLast) {
+        int level = 0;
+        while ((2 << level) <= innerLast - innerFirst + 1) {
+            ++level;
+        }
+        auto run = [&](int block) {
+            return level == 0 ? index.suffix.data() + block * blockSize * planeBytes
+                              : index.runs[level - 1].data() + block * planeBytes;
+        };
+        fold(out, run(innerFirst), pixels);
+        fold(out, run(innerLast - (1 << level) + 1), pixels);
+    }
+}
+
+/**
+ * Project the slab of slices z0 .. z1.
+ *
+ * @param method projMIP, projMinIP or projAIP; the method must have been indexed.
+ * @param z0 The first slice of the slab (1-based, inclusive).
+ * @param z1 The last slice of the slab (1-based, inclusive).
+ * @return The w * h projection, identical to projecting a volume loaded with minIndex = z0, maxIndex = z1.
+ */
+std::vector<unsigned char> SlabIndex::project(Projection::Proj method, int z0, int z1) const {
+    if (z0 < 1 || z1 < z0 || z1 > l) {
+        throw std::invalid_argument("slab [" + std::to_string(z0) + ", " + std::to_string(z1) + "] is outside the indexed volume");
+    }
+    std::vector<unsigned char> result(planeBytes);
+    int first = z0 - 1;
+    int last = z1 - 1;
+    switch (method) {
+        case Projection::projMIP:
+        case Projection::projMinIP: {
+            const ExtremumIndex& index = method == Projection::projMIP ? maxima : minima;
+            if (!index.built) {
+                throw std::invalid_argument("the slab index was built without this projection");
+            }
+            projectExtremum(index, method == Projection::projMIP, first, last, result.data());
+            break;
+        }
+        case Projection::projAIP: {
+            if (blockOffsets.empty()) {
+                throw std::invalid_argument("the slab index was built without this projection");
+            }
+            // sum of slices 0 .. last, minus the sum of slices 0 .. first - 1 when the slab does not start at 0
+            const uint32_t* throughSum = blockSums.data() + (last / sumBlockSize) * planeBytes;
+            const uint16_t* throughOffset = blockOffsets.data() + last * planeBytes;
+            int before = std::max(first - 1, 0);
+            const uint32_t* beforeSum = blockSums.data() + (before / sumBlockSize) * planeBytes;
+            const uint16_t* beforeOffset = blockOffsets.data() + before * planeBytes;
+            unsigned int count = last - first + 1;
+            for (size_t i = 0; i < planeBytes; ++i) {
+                uint32_t sum = throughSum[i] + throughOffset[i];
+                if (first > 0) {
+                    sum -= beforeSum[i] + beforeOffset[i];
+                }
+                result[i] = static_cast<unsigned char>(sum / count);
+            }
+            break;
+        }
+        default:
+            throw std::invalid_argument("slab projections support MIP, MinIP and AIP");
+    }
+    return result;
+}
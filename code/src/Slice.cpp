@@ -5,8 +5,15 @@
 #include <iostream>
 #include <algorithm>
 #include <functional>
+#include <cmath>
+#include <stdexcept>
 
+#include "ThreadPool.h"
+#include <utility>
 #include "stb_image.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "stb_image_write.h"
 
@@ -21,7 +28,7 @@
  * The generated slice is stored in the `result` vector of the `Volume` instance, ready for further processing or visualization.
  *
  * @param volume The volumetric dataset from which the slice is extracted.
- * @param x The X coordinate position at which the YZ slice is to be taken.
+ * @param x The X coordinate position at which the YZ slice is to be taken (1-based, like the slice indices of Volume).
  * 
  * @author: Ce Huang, Prayush Udas
  * Acknowledgement: Documentation aided by generative AI technology.
@@ -31,10 +38,10 @@ void Slice::sliceYZ(Volume& volume, int x){
     std::vector<unsigned char> slice(volume.h * volume.l);
     for (int z = 0; z < volume.l; ++z) {
         for (int y = 0; y < volume.h; ++y) {
-            slice[z * volume.h + y] = volume.data[z][y][x];
+            slice[z * volume.h + y] = volume.at(x - 1, y, z);
         }
     }
-    volume.slice = slice;
+    volume.slice = std::move(slice);
     volume.sliced = true;
 }
 
@@ -50,7 +57,7 @@ void Slice::sliceYZ(Volume& volume, int x){
  * visualization or analytical tasks.
  *
  * @param volume The volumetric dataset from which the slice is generated.
- * @param y The Y coordinate position at which the XZ slice is to be extracted.
+ * @param y The Y coordinate position at which the XZ slice is to be extracted (1-based, like the slice indices of Volume).
  * 
  * @author: Ce Huang, Prayush Udas
  * Acknowledgement: Documentation aided by generative AI technology.
@@ -59,17 +66,569 @@ void Slice::sliceYZ(Volume& volume, int x){
 void Slice::sliceXZ(Volume& volume, int y){
     std::vector<unsigned char> slice(volume.l * volume.w);
     for (int z = 0; z < volume.l; ++z) {
-        for (int x = 0; x < volume.w; ++x) {
-            slice[z * volume.w + x] = volume.data[z][y][x];
-        }
+        // each XZ row is a contiguous row of the XY slice at depth z
+        std::copy_n(volume.row(y - 1, z), volume.w, &slice[z * volume.w]);
     }
-    volume.slice = slice;
+    volume.slice = std::move(slice);
     volume.sliced = true;
 }
 
 
+/**
+ * @brief Returns a view of an XY slice of the volume without copying it.
+ *
+ * The view points straight at the slice's voxels, so the 2D filters can work on the slice in place and changes are
+ * seen by the volume. For a lazily loaded volume the view stays valid until the slice is evicted from the cache.
+ *
+ * @param volume The volumetric dataset to view.
+ * @param z The slice to view (1-based, like the slice indices of Volume).
+ * @return A w x h single-channel view whose stride is the volume's row stride.
+ */
+ImageView Slice::viewXY(Volume& volume, int z){
+    if (z < 1 || z > volume.l) {
+        throw std::invalid_argument("slice " + std::to_string(z) + " is outside the volume");
+    }
+    return {volume.slicePtr(z - 1), volume.w, volume.h, 1, volume.yStride};
+}
+
+/**
+ * @brief Returns a view of an XZ plane of the volume without copying it.
+ *
+ * Row z of the plane is row y of slice z, so the view's rows are one slice apart. It shows the same image as sliceXZ,
+ * with one row per slice, but reads and writes the volume directly. Lazily loaded volumes keep their slices in separate
+ * cache entries and cannot be viewed this way; use sliceXZ or materialize them first.
+ *
+ * @param volume The volumetric dataset to view.
+ * @param y The row to view (1-based, like sliceXZ).
+ * @return A w x l single-channel view whose stride is the volume's slice stride.
+ */
+ImageView Slice::viewXZ(Volume& volume, int y){
+    if (volume.isLazy()) {
+        throw std::invalid_argument("XZ views need a volume in memory");
+    }
+    if (y < 1 || y > volume.h) {
+        throw std::invalid_argument("row " + std::to_string(y) + " is outside the volume");
+    }
+    return {volume.row(y - 1, 0), volume.w, volume.l, 1, volume.zStride};
+}
+
+namespace {
+    /**
+     * Coordinates and weights of every sample along one output row, kept as separate arrays so that they can be
+     * computed four pixels at a time; only the voxel fetches are left per pixel.
+     */
+    struct RowSamples {
+        std::vector<int> x, y, z;
+        std::vector<float> fx, fy, fz;
+        std::vector<int> inside; // all bits set for samples within the volume
+        explicit RowSamples(int width) : x(width), y(width), z(width), fx(width), fy(width), fz(width), inside(width) {}
+    };
+
+    /**
+     * Fill in the samples of one row starting at voxel position `start` and moving by `step` per pixel. A sample
+     * is inside the volume if it is within half a voxel of a voxel centre; trilinear samples near the border then
+     * clamp to the edge voxels. For nearest sampling the weights are unused. The SSE2 loop and the scalar tail
+     * compute positions identically, so the result does not depend on the row width.
+     */
+    void placeSamples(RowSamples& samples, const int dims[3], const float start[3], const float step[3], int width, bool trilinear) {
+        int* index[3] = {samples.x.data(), samples.y.data(), samples.z.data()};
+        float* weight[3] = {samples.fx.data(), samples.fy.data(), samples.fz.data()};
+        std::fill(samples.inside.begin(), samples.inside.end(), -1);
+        for (int a = 0; a < 3; ++a) {
+            int* cell = index[a];
+            float* fraction = weight[a];
+            int* inside = samples.inside.data();
+            float origin = start[a], delta = step[a];
+            float upper = static_cast<float>(dims[a] - 1);
+            float lastCell = static_cast<float>(std::max(dims[a] - 2, 0));
+            int i = 0;
+#ifdef __SSE2__
+            const __m128 lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+            for (; i + 4 <= width; i += 4) {
+                __m128 position = _mm_add_ps(_mm_set1_ps(origin), _mm_mul_ps(_mm_add_ps(_mm_set1_ps(static_cast<float>(i)), lanes), _mm_set1_ps(delta)));
+                __m128 within = _mm_and_ps(_mm_cmpge_ps(position, _mm_set1_ps(-0.5f)), _mm_cmplt_ps(position, _mm_set1_ps(upper + 0.5f)));
+                __m128i* flags = reinterpret_cast<__m128i*>(inside + i);
+                _mm_storeu_si128(flags, _mm_and_si128(_mm_loadu_si128(flags), _mm_castps_si128(within)));
+                __m128 clamped = _mm_min_ps(_mm_max_ps(position, _mm_setzero_ps()), _mm_set1_ps(upper));
+                if (trilinear) {
+                    __m128i lower = _mm_cvttps_epi32(_mm_min_ps(clamped, _mm_set1_ps(lastCell)));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(cell + i), lower);
+                    _mm_storeu_ps(fraction + i, _mm_sub_ps(clamped, _mm_cvtepi32_ps(lower)));
+                } else {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(cell + i), _mm_cvttps_epi32(_mm_add_ps(clamped, _mm_set1_ps(0.5f))));
+                }
+            }
+#endif
+            for (; i < width; ++i) {
+                float position = origin + static_cast<float>(i) * delta;
+                if (!(position >= -0.5f && position < upper + 0.5f)) {
+                    inside[i] = 0;
+                }
+                float clamped = std::min(std::max(position, 0.0f), upper);
+                if (trilinear) {
+                    cell[i] = static_cast<int>(std::min(clamped, lastCell));
+                    fraction[i] = clamped - static_cast<float>(cell[i]);
+                } else {
+                    cell[i] = static_cast<int>(clamped + 0.5f);
+                }
+            }
+        }
+    }
+
+    /**
+     * Resample one output row of `width` pixels starting at voxel position `start` and moving by `step` per pixel;
+     * `sliceAt(z)` gives the first voxel of slice z, whose rows are `yStride` bytes apart. A trilinear sample looks
+     * up its two slices once each and blends the four voxels of one before looking up the other, so a lazy volume
+     * whose cache holds a single slice never reads a slice that has just been evicted.
+     */
+    template <typename SliceAt>
+    void resampleRow(const SliceAt& sliceAt, size_t yStride, const int dims[3], const float start[3], const float step[3],
+                     int width, bool trilinear, RowSamples& samples, unsigned char* row) {
+        int dx = dims[0] > 1, dy = dims[1] > 1, dz = dims[2] > 1;
+        placeSamples(samples, dims, start, step, width, trilinear);
+        for (int i = 0; i < width; ++i) {
+            if (!samples.inside[i]) {
+                row[i] = 0;
+                continue;
+            }
+            int x = samples.x[i], y = samples.y[i], z = samples.z[i];
+            if (!trilinear) {
+                row[i] = sliceAt(z)[y * yStride + x];
+                continue;
+            }
+            float fx = samples.fx[i], fy = samples.fy[i], fz = samples.fz[i];
+            auto bilinear = [&](const unsigned char* slice) {
+                const unsigned char* top = slice + y * yStride + x;
+                const unsigned char* bottom = top + dy * yStride;
+                float c0 = top[0] + fx * (top[dx] - top[0]);
+                float c1 = bottom[0] + fx * (bottom[dx] - bottom[0]);
+                return c0 + fy * (c1 - c0);
+            };
+            float c0 = bilinear(sliceAt(z));
+            float c1 = bilinear(sliceAt(z + dz));
+            row[i] = static_cast<unsigned char>(std::lround(c0 + fz * (c1 - c0)));
+        }
+    }
+
+    /**
+     * Resample rows first .. last - 1 of a planar slice whose row j starts at corner + j * down.
+     */
+    template <typename SliceAt>
+    void resliceRows(const SliceAt& sliceAt, size_t yStride, const int dims[3], const float corner[3], const float across[3],
+                     const float down[3], int width, int first, int last, bool trilinear, unsigned char* out) {
+        RowSamples samples(width);
+        for (int j = first; j < last; ++j) {
+            float start[3] = {corner[0] + j * down[0], corner[1] + j * down[1], corner[2] + j * down[2]};
+            resampleRow(sliceAt, yStride, dims, start, across, width, trilinear, samples, out + static_cast<size_t>(j) * width);
+        }
+    }
+
+    /**
+     * Gram-Schmidt the volume axes, in the order x, y, z, against the first `found` rows of `basis` and append those
+     * that are not within 30 degrees of the span, until `wanted` orthonormal directions have been found.
+     */
+    int completeBasis(float basis[3][3], int found, int wanted) {
+        for (int axis = 0; axis < 3 && found < wanted; ++axis) {
+            float candidate[3] = {0.0f, 0.0f, 0.0f};
+            candidate[axis] = 1.0f;
+            for (int k = 0; k < found; ++k) {
+                float dot = candidate[0] * basis[k][0] + candidate[1] * basis[k][1] + candidate[2] * basis[k][2];
+                for (int a = 0; a < 3; ++a) {
+                    candidate[a] -= dot * basis[k][a];
+                }
+            }
+            float norm = std::sqrt(candidate[0] * candidate[0] + candidate[1] * candidate[1] + candidate[2] * candidate[2]);
+            if (norm > 0.5f) {
+                for (int a = 0; a < 3; ++a) {
+                    basis[found][a] = candidate[a] / norm;
+                }
+                ++found;
+            }
+        }
+        return found;
+    }
+
+    using Point = std::array<float, 3>;
+
+    float dot(const Point& a, const Point& b) {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    Point axpy(float s, const Point& a, const Point& b) { // s * a + b
+        return {s * a[0] + b[0], s * a[1] + b[1], s * a[2] + b[2]};
+    }
+
+    /**
+     * The points of `path` in physical units, with repeated points dropped. A spline is replaced by a dense polyline
+     * on its Catmull-Rom curve, with a vertex at least every half pixel, so that it can be walked by arc length like a
+     * polyline.
+     */
+    std::vector<Point> physicalPath(const std::vector<Point>& path, const float spacing[3], bool spline, float pixel) {
+        std::vector<Point> points;
+        for (const Point& p : path) {
+            Point q = {p[0] * spacing[0], p[1] * spacing[1], p[2] * spacing[2]};
+            if (points.empty() || q != points.back()) {
+                points.push_back(q);
+            }
+        }
+        if (!spline || points.size() < 3) {
+            return points;
+        }
+        std::vector<Point> dense{points.front()};
+        size_t n = points.size();
+        for (size_t k = 0; k + 1 < n; ++k) {
+            const Point& p0 = points[k == 0 ? 0 : k - 1];
+            const Point& p1 = points[k];
+            const Point& p2 = points[k + 1];
+            const Point& p3 = points[std::min(k + 2, n - 1)];
+            Point chord = axpy(-1.0f, p1, p2);
+            int steps = std::max(1, static_cast<int>(std::ceil(2.0f * std::sqrt(dot(chord, chord)) / pixel)));
+            for (int s = 1; s <= steps; ++s) {
+                float t = static_cast<float>(s) / steps, t2 = t * t, t3 = t2 * t;
+                Point q;
+                for (int a = 0; a < 3; ++a) {
+                    q[a] = 0.5f * (2.0f * p1[a] + (p2[a] - p0[a]) * t + (2.0f * p0[a] - 5.0f * p1[a] + 4.0f * p2[a] - p3[a]) * t2 +
+                                   (3.0f * p1[a] - p0[a] - 3.0f * p2[a] + p3[a]) * t3);
+                }
+                if (q != dense.back()) {
+                    dense.push_back(q);
+                }
+            }
+        }
+        return dense;
+    }
+}
+
+/**
+ * @brief Resamples the volume on an arbitrary plane.
+ *
+ * The plane passes through `point` and is perpendicular to `normal`. Its pixels are laid out on two orthonormal
+ * in-plane directions taken from the volume axes in the order x, y, z, skipping any axis within 30 degrees of the
+ * normal, so the axis-aligned planes come out like the existing slices: a normal along z gives the XY slice, along y
+ * the XZ slice of sliceXZ and along x the YZ slice of sliceYZ, each with slices running down the image. The image is
+ * centred on `point`. Voxel spacing is honoured, so both the normal and the pixel size are in physical units.
+ *
+ * Each output row is resampled in two steps: the coordinates and weights of all of its samples, computed four pixels
+ * at a time with SSE2, and then the voxel fetches and blends. Rows are split across the shared thread pool;
+ * a lazily loaded volume is resliced on the calling thread, since its slices can be evicted between fetches.
+ * Pixels further than half a voxel outside the volume are 0.
+ *
+ * @param volume The volumetric dataset to resample.
+ * @param point A point on the plane, in 0-based voxel coordinates; it becomes the centre of the image.
+ * @param normal The normal of the plane; it does not need to be normalised.
+ * @param width The width of the resulting image in pixels.
+ * @param height The height of the resulting image in pixels.
+ * @param sampling Nearest or Trilinear interpolation between voxels.
+ * @param pixelSize The pixel size, in units of the finest voxel spacing.
+ * @return A single-channel width x height image; its data is allocated with new[] and owned by the caller.
+ */
+Image Slice::sliceOblique(const Volume& volume, const std::array<float, 3>& point, const std::array<float, 3>& normal,
+                          int width, int height, Sampling sampling, float pixelSize) {
+    float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+    if (width <= 0 || height <= 0 || !(pixelSize > 0.0f) || !(length > 0.0f)) {
+        throw std::invalid_argument("oblique slices need a positive size, a positive pixel size and a non-zero normal");
+    }
+
+    // orthonormal in-plane directions by Gram-Schmidt on the volume axes
+    float basis[3][3] = {{normal[0] / length, normal[1] / length, normal[2] / length}};
+    completeBasis(basis, 1, 3);
+
+    // per-pixel steps and the position of the top-left pixel, in voxel coordinates
+    float unit = std::min({volume.spacing[0], volume.spacing[1], volume.spacing[2]});
+    float pixel = pixelSize * unit;
+    float across[3], down[3], corner[3];
+    for (int a = 0; a < 3; ++a) {
+        across[a] = pixel * basis[1][a] / volume.spacing[a];
+        down[a] = pixel * basis[2][a] / volume.spacing[a];
+        corner[a] = point[a] - 0.5f * (width - 1) * across[a] - 0.5f * (height - 1) * down[a];
+    }
+
+    Image image;
+    image.w = width;
+    image.h = height;
+    image.c = 1;
+    image.data = new unsigned char[static_cast<size_t>(width) * height]();
+    int dims[3] = {volume.w, volume.h, volume.l};
+    if (volume.w <= 0 || volume.h <= 0 || volume.l <= 0) {
+        return image;
+    }
+    bool trilinear = sampling == Trilinear;
+
+    size_t yStride = volume.yStride;
+    if (volume.isLazy()) {
+        auto sliceAt = [&](int z) { return volume.slicePtr(z); };
+        resliceRows(sliceAt, yStride, dims, corner, across, down, width, 0, height, trilinear, image.data);
+        return image;
+    }
+    const unsigned char* voxels = volume.data.data();
+    size_t zStride = volume.zStride;
+    auto sliceAt = [=](int z) { return voxels + z * zStride; };
+    ThreadPool& pool = ThreadPool::shared();
+    int bands = std::min<int>(height, pool.size() * 4);
+    pool.parallelFor(0, bands, [&](int band) {
+        int first = static_cast<int>(static_cast<long long>(height) * band / bands);
+        int last = static_cast<int>(static_cast<long long>(height) * (band + 1) / bands);
+        resliceRows(sliceAt, yStride, dims, corner, across, down, width, first, last, trilinear, image.data);
+    });
+    return image;
+}
+
+/**
+ * @brief Resamples the volume along a curved path (curved planar reformation).
+ *
+ * The path is walked at steps of one pixel along its arc length, and every step becomes a row of the image: the row
+ * is a line of `width` pixels centred on the path and perpendicular to it, so a vessel or other tubular structure the
+ * path follows runs straight down the middle of the image. The direction across each row comes from a
+ * rotation-minimising frame carried along the path by double reflection, starting from the first volume axis (x, then
+ * y, then z) that is not within 30 degrees of the path; it turns only as much as the path does, so the image does not
+ * twist around straight stretches. A straight path along z therefore gives the XZ slice through it, like sliceXZ.
+ *
+ * A Polyline path is followed through its points with sharp corners; a Spline path is a Catmull-Rom curve through
+ * them. Voxel spacing is honoured, so arc length and pixel size are physical. The frames are computed once on the
+ * calling thread, and the rows are then resampled in parallel bands across the shared thread pool with the same
+ * row resampler as sliceOblique; a lazily loaded volume is resampled on the calling thread. Pixels further than
+ * half a voxel outside the volume are 0.
+ *
+ * @param volume The volumetric dataset to resample.
+ * @param path The points the path passes through, in 0-based voxel coordinates; at least two distinct points.
+ * @param width The width of the resulting image in pixels, across the path.
+ * @param curve Polyline or Spline interpolation between the points.
+ * @param sampling Nearest or Trilinear interpolation between voxels.
+ * @param pixelSize The pixel size, and the step along the path, in units of the finest voxel spacing.
+ * @return A single-channel image with one row per step along the path; its data is allocated with new[] and owned
+ *         by the caller.
+ */
+Image Slice::sliceCurved(const Volume& volume, const std::vector<std::array<float, 3>>& path, int width, Curve curve,
+                         Sampling sampling, float pixelSize) {
+    if (width <= 0 || !(pixelSize > 0.0f)) {
+        throw std::invalid_argument("curved slices need a positive width and a positive pixel size");
+    }
+    float unit = std::min({volume.spacing[0], volume.spacing[1], volume.spacing[2]});
+    float pixel = pixelSize * unit;
+    std::vector<Point> points = physicalPath(path, volume.spacing, curve == Spline, pixel);
+    if (points.size() < 2) {
+        throw std::invalid_argument("curved slices need a path through at least two distinct points");
+    }
+
+    // arc length at every vertex, and the number of rows that fit along it
+    std::vector<float> arc(points.size(), 0.0f);
+    for (size_t k = 1; k < points.size(); ++k) {
+        Point chord = axpy(-1.0f, points[k - 1], points[k]);
+        arc[k] = arc[k - 1] + std::sqrt(dot(chord, chord));
+    }
+    int height = static_cast<int>(std::floor(arc.back() / pixel + 1e-4f)) + 1;
+
+    // centre and tangent of every row, then the rotation-minimising frame along them
+    std::vector<Point> centres(height), tangents(height), normals(height);
+    size_t segment = 0;
+    for (int j = 0; j < height; ++j) {
+        float s = std::min(j * pixel, arc.back());
+        while (segment + 2 < points.size() && arc[segment + 1] < s) {
+            ++segment;
+        }
+        Point chord = axpy(-1.0f, points[segment], points[segment + 1]);
+        float length = arc[segment + 1] - arc[segment];
+        centres[j] = axpy((s - arc[segment]) / length, chord, points[segment]);
+        tangents[j] = {chord[0] / length, chord[1] / length, chord[2] / length};
+    }
+    float basis[3][3] = {{tangents[0][0], tangents[0][1], tangents[0][2]}};
+    completeBasis(basis, 1, 2);
+    normals[0] = {basis[1][0], basis[1][1], basis[1][2]};
+    for (int j = 1; j < height; ++j) {
+        Point reflect = axpy(-1.0f, centres[j - 1], centres[j]);
+        float c1 = dot(reflect, reflect);
+        Point normal = normals[j - 1], tangent = tangents[j - 1];
+        if (c1 > 0.0f) {
+            normal = axpy(-2.0f * dot(reflect, normal) / c1, reflect, normal);
+            tangent = axpy(-2.0f * dot(reflect, tangent) / c1, reflect, tangent);
+        }
+        Point second = axpy(-1.0f, tangent, tangents[j]);
+        float c2 = dot(second, second);
+        if (c2 > 0.0f) {
+            normal = axpy(-2.0f * dot(second, normal) / c2, second, normal);
+        }
+        // keep the frame orthonormal against rounding
+        normal = axpy(-dot(normal, tangents[j]), tangents[j], normal);
+        float norm = std::sqrt(dot(normal, normal));
+        normals[j] = {normal[0] / norm, normal[1] / norm, normal[2] / norm};
+    }
+
+    // per-row start and step in voxel coordinates
+    std::vector<float> starts(static_cast<size_t>(height) * 3), steps(static_cast<size_t>(height) * 3);
+    for (int j = 0; j < height; ++j) {
+        for (int a = 0; a < 3; ++a) {
+            float step = pixel * normals[j][a] / volume.spacing[a];
+            steps[j * 3 + a] = step;
+            starts[j * 3 + a] = centres[j][a] / volume.spacing[a] - 0.5f * (width - 1) * step;
+        }
+    }
+
+    Image image;
+    image.w = width;
+    image.h = height;
+    image.c = 1;
+    image.data = new unsigned char[static_cast<size_t>(width) * height]();
+    int dims[3] = {volume.w, volume.h, volume.l};
+    if (volume.w <= 0 || volume.h <= 0 || volume.l <= 0) {
+        return image;
+    }
+    bool trilinear = sampling == Trilinear;
+    size_t yStride = volume.yStride;
+    auto resampleRows = [&](const auto& sliceAt, int first, int last) {
+        RowSamples samples(width);
+        for (int j = first; j < last; ++j) {
+            resampleRow(sliceAt, yStride, dims, &starts[j * 3], &steps[j * 3], width, trilinear, samples, image.data + static_cast<size_t>(j) * width);
+        }
+    };
+
+    if (volume.isLazy()) {
+        resampleRows([&](int z) { return volume.slicePtr(z); }, 0, height);
+        return image;
+    }
+    const unsigned char* voxels = volume.data.data();
+    size_t zStride = volume.zStride;
+    auto sliceAt = [=](int z) { return voxels + z * zStride; };
+    ThreadPool& pool = ThreadPool::shared();
+    int bands = std::min<int>(height, pool.size() * 4);
+    pool.parallelFor(0, bands, [&](int band) {
+        int first = static_cast<int>(static_cast<long long>(height) * band / bands);
+        int last = static_cast<int>(static_cast<long long>(height) * (band + 1) / bands);
+        resampleRows(sliceAt, first, last);
+    });
+    return image;
+}
 
 
+namespace {
+    /**
+     * Write the transpose of the 16 x 16 block of bytes at `src` to `dst`: row k of the result, column k of the
+     * block, is stored at dst + k * dstStride. SSE2 does it in registers with four rounds of interleaving.
+     */
+    void transposeTile(const unsigned char* src, size_t srcStride, unsigned char* dst, size_t dstStride) {
+#ifdef __SSE2__
+        __m128i rows[16];
+        for (int k = 0; k < 16; ++k) {
+            rows[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + k * srcStride));
+        }
+        // each round interleaves rows k and k + 8 at twice the width of the previous one
+        __m128i mixed[16];
+        for (int k = 0; k < 8; ++k) {
+            mixed[2 * k] = _mm_unpacklo_epi8(rows[k], rows[k + 8]);
+            mixed[2 * k + 1] = _mm_unpackhi_epi8(rows[k], rows[k + 8]);
+        }
+        for (int k = 0; k < 8; ++k) {
+            rows[2 * k] = _mm_unpacklo_epi8(mixed[k], mixed[k + 8]);
+            rows[2 * k + 1] = _mm_unpackhi_epi8(mixed[k], mixed[k + 8]);
+        }
+        for (int k = 0; k < 8; ++k) {
+            mixed[2 * k] = _mm_unpacklo_epi8(rows[k], rows[k + 8]);
+            mixed[2 * k + 1] = _mm_unpackhi_epi8(rows[k], rows[k + 8]);
+        }
+        for (int k = 0; k < 8; ++k) {
+            rows[2 * k] = _mm_unpacklo_epi8(mixed[k], mixed[k + 8]);
+            rows[2 * k + 1] = _mm_unpackhi_epi8(mixed[k], mixed[k + 8]);
+        }
+        for (int k = 0; k < 16; ++k) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + k * dstStride), rows[k]);
+        }
+#else
+        for (int k = 0; k < 16; ++k) {
+            for (int j = 0; j < 16; ++j) {
+                dst[k * dstStride + j] = src[j * srcStride + k];
+            }
+        }
+#endif
+    }
 
+    /**
+     * Scatter columns first .. last - 1 of one XY slice into row z of the YZ-major volume `out`, where column x
+     * becomes row z of slice x. Columns are taken 64 at a time, so every source cache line read is used in full,
+     * and each 64-column block is walked down all rows in 16 x 16 tiles.
+     */
+    void transposeSlice(const unsigned char* slice, size_t sliceStride, int h, Volume& out, int z, int first, int last) {
+        const int block = 64;
+        for (int x0 = first; x0 < last; x0 += block) {
+            int x1 = std::min(x0 + block, last);
+            int y = 0;
+            for (; y + 16 <= h; y += 16) {
+                int x = x0;
+                for (; x + 16 <= x1; x += 16) {
+                    transposeTile(slice + y * sliceStride + x, sliceStride, out.row(z, x) + y, out.zStride);
+                }
+                for (; x < x1; ++x) {
+                    unsigned char* column = out.row(z, x) + y;
+                    for (int k = 0; k < 16; ++k) {
+                        column[k] = slice[(y + k) * sliceStride + x];
+                    }
+                }
+            }
+            for (; y < h; ++y) {
+                for (int x = x0; x < x1; ++x) {
+                    out.row(z, x)[y] = slice[y * sliceStride + x];
+                }
+            }
+        }
+    }
+}
 
+/**
+ * @brief Re-orients a volume so that its XZ or YZ planes become contiguous slices.
+ *
+ * Taking many sliceYZ views gathers one voxel per slice for every pixel. Re-orienting the volume once turns each
+ * of those views into an ordinary slice of the result: slice k of the XZ-major volume is sliceXZ(k + 1), an image
+ * with one row per original slice, and likewise for YZ. Spacing is permuted to match.
+ *
+ * The XZ order keeps rows intact, so it is a row-by-row copy. The YZ order is a true transpose of each XY slice:
+ * it is done in blocks of 64 columns and tiles of 16 x 16 voxels, which are transposed in SSE2 registers where
+ * available. Slices are processed in parallel on the shared pool; for a lazily loaded volume each slice is fetched
+ * on the calling thread and its columns are split across threads instead.
+ *
+ * @param volume The volumetric dataset to re-orient; it is not modified.
+ * @param plane XZ or YZ.
+ * @return A new in-memory volume: w x l x h for XZ and h x l x w for YZ.
+ */
+Volume Slice::reorient(const Volume& volume, Plane plane) {
+    Volume out = plane == XZ ? Volume::allocated(volume.w, volume.l, volume.h) : Volume::allocated(volume.h, volume.l, volume.w);
+    out.path = volume.path;
+    if (plane == XZ) {
+        out.spacing[0] = volume.spacing[0];
+        out.spacing[1] = volume.spacing[2];
+        out.spacing[2] = volume.spacing[1];
+    } else {
+        out.spacing[0] = volume.spacing[1];
+        out.spacing[1] = volume.spacing[2];
+        out.spacing[2] = volume.spacing[0];
+    }
 
+    auto copySlice = [&](int z, const unsigned char* slice, int first, int last) {
+        if (plane == XZ) {
+            for (int y = first; y < last; ++y) {
+                std::copy_n(slice + y * volume.yStride, volume.w, out.row(z, y));
+            }
+        } else {
+            transposeSlice(slice, volume.yStride, volume.h, out, z, first, last);
+        }
+    };
+    ThreadPool& pool = ThreadPool::shared();
+    if (volume.isLazy()) {
+        int span = plane == XZ ? volume.h : volume.w;
+        int bands = std::min<int>(span, pool.size() * 4);
+        for (int z = 0; z < volume.l; ++z) {
+            const unsigned char* slice = volume.slicePtr(z);
+            pool.parallelFor(0, bands, [&](int band) {
+                int first = static_cast<int>(static_cast<long long>(span) * band / bands);
+                int last = static_cast<int>(static_cast<long long>(span) * (band + 1) / bands);
+                if (plane == YZ) { // keep bands on whole 16-column tiles
+                    first = first / 16 * 16;
+                    last = band == bands - 1 ? span : last / 16 * 16;
+                }
+                copySlice(z, slice, first, last);
+            });
+        }
+    } else {
+        pool.parallelFor(0, volume.l, [&](int z) {
+            copySlice(z, volume.slicePtr(z), 0, plane == XZ ? volume.h : volume.w);
+        });
+    }
+    return out;
+}
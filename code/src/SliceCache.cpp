@@ -0,0 +1,79 @@
+#include "SliceCache.h"
+#include "stb_image.h"
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+/**
+ * Create an empty cache for the given slice files.
+ *
+ * @param files The PNG file of each slice, in z order.
+ * @param w The width of every slice.
+ * @param h The height of every slice.
+ * @param budgetBytes The maximum number of bytes of decoded slices to keep; at least one slice is always kept.
+ */
+SliceCache::SliceCache(std::vector<std::string> files, int w, int h, size_t budgetBytes)
+    : files(std::move(files)), w(w), h(h), sliceBytes(static_cast<size_t>(w) * h), budgetBytes(budgetBytes) {
+    capacity = std::max<size_t>(1, sliceBytes == 0 ? 1 : budgetBytes / sliceBytes);
+}
+
+/**
+ * Decode slice z as grayscale. A slice that cannot be decoded, or whose size does not match the
+ * volume, is reported and replaced by a zeroed slice so callers always get valid memory.
+ */
+std::unique_ptr<unsigned char, void(*)(void*)> SliceCache::decode(int z){
+    int imgW, imgH, imgC;
+    unsigned char* imgData = stbi_load(files[z].c_str(), &imgW, &imgH, &imgC, 1);
+    if (imgData == nullptr || imgW != w || imgH != h) {
+        std::cerr << "[ERROR] Failed to load image: " << files[z] << std::endl;
+        stbi_image_free(imgData);
+        imgData = static_cast<unsigned char*>(std::calloc(sliceBytes == 0 ? 1 : sliceBytes, 1));
+        return {imgData, std::free};
+    }
+    return {imgData, stbi_image_free};
+}
+
+/**
+ * Return slice z, decoding it on a miss and evicting the least recently used slices to stay within
+ * the budget. Decoding happens outside the lock so that several threads can miss at once.
+ *
+ * @param z The 0-based slice index.
+ */
+unsigned char* SliceCache::slice(int z){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = entries.find(z);
+        if (found != entries.end()) {
+            recent.splice(recent.begin(), recent, found->second.position);
+            return found->second.pixels.get();
+        }
+    }
+
+    auto pixels = decode(z);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ++decoded;
+    auto found = entries.find(z);
+    if (found != entries.end()) { // another thread decoded it first
+        recent.splice(recent.begin(), recent, found->second.position);
+        return found->second.pixels.get();
+    }
+    while (entries.size() >= capacity) {
+        entries.erase(recent.back());
+        recent.pop_back();
+    }
+    recent.push_front(z);
+    auto inserted = entries.emplace(z, Entry{std::move(pixels), recent.begin()});
+    return inserted.first->second.pixels.get();
+}
+
+size_t SliceCache::residentBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size() * sliceBytes;
+}
+
+int SliceCache::decodedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return decoded;
+}
@@ -0,0 +1,133 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+/**
+ * Start the worker threads. The calling thread of parallelFor counts as one of the threads, so
+ * `threads - 1` workers are created.
+ *
+ * @param threads The total number of threads to use, or 0 for the hardware concurrency.
+ */
+ThreadPool::ThreadPool(unsigned threads){
+    if (threads == 0) {
+        threads = hardwareThreads();
+    }
+    for (unsigned i = 1; i < threads; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+/**
+ * Let the workers drain the queue and join them.
+ */
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+/**
+ * The number of hardware threads, never less than one.
+ */
+unsigned ThreadPool::hardwareThreads(){
+    unsigned n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+/**
+ * A pool shared by the whole process, created on first use with one thread per hardware thread.
+ */
+ThreadPool& ThreadPool::shared(){
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::workerLoop(){
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (jobs.empty()) {
+                return;
+            }
+            job = std::move(jobs.front());
+            jobs.pop();
+        }
+        job();
+    }
+}
+
+/**
+ * Run task(i) for every i in [begin, end), handing indices out one at a time from a shared counter so
+ * that uneven work (e.g. slices that decode at different speeds) stays balanced.
+ *
+ * Completion is tracked per index rather than per worker: helpers that only start after the range is
+ * exhausted return immediately, which keeps nested calls from waiting on queued jobs.
+ *
+ * @param begin The first index.
+ * @param end One past the last index.
+ * @param task The function to call for each index.
+ */
+void ThreadPool::parallelFor(int begin, int end, const std::function<void(int)>& task){
+    if (end <= begin) {
+        return;
+    }
+    struct Loop {
+        std::atomic<int> next;
+        int end;
+        int remaining;
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr error;
+        const std::function<void(int)>* task;
+    };
+    auto loop = std::make_shared<Loop>();
+    loop->next = begin;
+    loop->end = end;
+    loop->remaining = end - begin;
+    loop->task = &task;
+
+    // Only the thread that finishes the last index wakes the caller; by then `task` is no longer used.
+    auto run = [](const std::shared_ptr<Loop>& loop) {
+        for (int i = loop->next++; i < loop->end; i = loop->next++) {
+            try {
+                (*loop->task)(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(loop->mutex);
+                if (!loop->error) {
+                    loop->error = std::current_exception();
+                }
+            }
+            std::lock_guard<std::mutex> lock(loop->mutex);
+            if (--loop->remaining == 0) {
+                loop->done.notify_all();
+            }
+        }
+    };
+
+    unsigned helpers = std::min<unsigned>(static_cast<unsigned>(workers.size()), static_cast<unsigned>(end - begin - 1));
+    if (helpers > 0) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (unsigned i = 0; i < helpers; ++i) {
+                jobs.push([loop, run] { run(loop); });
+            }
+        }
+        wake.notify_all();
+    }
+    run(loop);
+
+    std::unique_lock<std::mutex> lock(loop->mutex);
+    loop->done.wait(lock, [&] { return loop->remaining == 0; });
+    if (loop->error) {
+        std::rethrow_exception(loop->error);
+    }
+}
@@ -2,20 +2,213 @@
 #include "Volume.h"
 #include "stb_image.h"
 #include "stb_image_write.h"
+#include "ThreadPool.h"
+#include <new>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include <bit>
+#include <fstream>
+#include <utility>
+#include <stdexcept>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
+namespace {
+    /**
+     * Header of the native ".vol" format. Fields are stored little-endian, and the voxels start at
+     * `headerBytes` (one page) so that a mapping of the file has its first voxel page-aligned. The header is
+     * copied to and from the file as it is laid out in memory, so this only holds on little-endian hosts.
+     */
+    struct VolumeFileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerBytes;
+        uint32_t w, h, l;
+        uint32_t channels;
+        uint32_t voxelType;
+        float spacing[3];
+    };
+    static_assert(std::endian::native == std::endian::little, "the native volume header is read and written in host byte order");
+    constexpr char volumeMagic[8] = {'A', 'C', 'S', 'V', 'O', 'L', '\0', '\0'};
+    constexpr uint32_t volumeVersion = 1;
+    constexpr uint32_t volumeHeaderBytes = 4096;
+    constexpr uint32_t voxelTypeUint8 = 1;
 
+    /**
+     * Write the header block of a native volume with the dimensions and spacing of `volume`.
+     */
+    void writeNativeHeader(std::ostream& file, const Volume& volume) {
+        VolumeFileHeader header{};
+        std::memcpy(header.magic, volumeMagic, sizeof(volumeMagic));
+        header.version = volumeVersion;
+        header.headerBytes = volumeHeaderBytes;
+        header.w = volume.w;
+        header.h = volume.h;
+        header.l = volume.l;
+        header.channels = 1;
+        header.voxelType = voxelTypeUint8;
+        std::copy(volume.spacing, volume.spacing + 3, header.spacing);
+
+        std::vector<char> headerBlock(volumeHeaderBytes, 0);
+        std::memcpy(headerBlock.data(), &header, sizeof(header));
+        file.write(headerBlock.data(), headerBlock.size());
+    }
+
+    /**
+     * Set `product` to a * b, or return false if the product does not fit in a size_t.
+     */
+    bool checkedMultiply(size_t a, size_t b, size_t& product) {
+        if (a != 0 && b > SIZE_MAX / a) {
+            return false;
+        }
+        product = a * b;
+        return true;
+    }
+}
 
 /**
- * @brief Construct a new Volume:: Volume object. Load the images from the directory and store them in a 3D vector.
- * 
+ * Allocate a zeroed, 64-byte aligned block of voxel memory.
+ *
+ * @param bytes The number of bytes to allocate.
+ */
+VoxelBuffer::VoxelBuffer(size_t bytes) : bytes(bytes) {
+    if (bytes > 0) {
+        ptr = static_cast<unsigned char*>(::operator new[](bytes, std::align_val_t(alignment)));
+        std::memset(ptr, 0, bytes);
+    }
+}
+
+VoxelBuffer::VoxelBuffer(const VoxelBuffer& other) : VoxelBuffer(other.bytes) {
+    if (bytes > 0) {
+        std::memcpy(ptr, other.ptr, bytes);
+    }
+}
+
+VoxelBuffer::VoxelBuffer(VoxelBuffer&& other) noexcept {
+    swap(other);
+}
+
+VoxelBuffer& VoxelBuffer::operator=(VoxelBuffer other) noexcept {
+    swap(other);
+    return *this;
+}
+
+VoxelBuffer::~VoxelBuffer() {
+#ifndef _WIN32
+    if (mapping) {
+        munmap(mapping, mappingBytes);
+        return;
+    }
+#endif
+    if (ptr) {
+        ::operator delete[](ptr, std::align_val_t(alignment));
+    }
+}
+
+void VoxelBuffer::swap(VoxelBuffer& other) noexcept {
+    std::swap(ptr, other.ptr);
+    std::swap(bytes, other.bytes);
+    std::swap(mapping, other.mapping);
+    std::swap(mappingBytes, other.mappingBytes);
+}
+
+/**
+ * Map part of a file into memory. The whole file is mapped private and copy-on-write, so writes through
+ * the buffer never reach the file and untouched pages are never read. Platforms without mmap read the
+ * requested bytes into an ordinary buffer instead.
+ *
+ * @param filename The file to map.
+ * @param offset The byte offset of the first byte of the buffer within the file.
+ * @param bytes The number of bytes in the buffer.
+ */
+VoxelBuffer VoxelBuffer::mapFile(const std::string& filename, size_t offset, size_t bytes) {
+#ifndef _WIN32
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open " + filename);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || offset > static_cast<size_t>(info.st_size) || bytes > static_cast<size_t>(info.st_size) - offset) {
+        close(fd);
+        throw std::runtime_error(filename + " is shorter than its header describes");
+    }
+    VoxelBuffer buffer;
+    if (bytes > 0) {
+        void* base = mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (base == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Cannot map " + filename);
+        }
+        buffer.mapping = base;
+        buffer.mappingBytes = info.st_size;
+        buffer.ptr = static_cast<unsigned char*>(base) + offset;
+        buffer.bytes = bytes;
+    }
+    close(fd); // the mapping stays valid after the descriptor is closed
+    return buffer;
+#else
+    std::ifstream file(filename, std::ios::binary);
+    VoxelBuffer buffer(bytes);
+    file.seekg(offset);
+    if (!file.read(reinterpret_cast<char*>(buffer.data()), bytes)) {
+        throw std::runtime_error(filename + " is shorter than its header describes");
+    }
+    return buffer;
+#endif
+}
+
+/**
+ * Set the dimensions of the volume and allocate zeroed storage for them. Rows are padded to a
+ * multiple of VoxelBuffer::alignment so every row and every slice starts on a 64-byte boundary.
+ * Any lazy slice cache is dropped, since the voxels now live in the new buffer.
+ *
+ * @param width The number of voxels in each row.
+ * @param height The number of rows in each slice.
+ * @param depth The number of slices.
+ */
+void Volume::allocate(int width, int height, int depth) {
+    w = width;
+    h = height;
+    l = depth;
+    c = 1;
+    xStride = 1;
+    yStride = (static_cast<size_t>(width) + VoxelBuffer::alignment - 1) / VoxelBuffer::alignment * VoxelBuffer::alignment;
+    zStride = yStride * height;
+    data = VoxelBuffer(zStride * depth);
+    cache.reset();
+}
+
+/**
+ * Create an in-memory volume of the given dimensions with zeroed voxels, as allocate() lays them out.
+ * Unlike a default-constructed volume that is then allocated, nothing is logged.
+ *
+ * @param width The number of voxels in each row.
+ * @param height The number of rows in each slice.
+ * @param depth The number of slices.
+ */
+Volume Volume::allocated(int width, int height, int depth) {
+    Volume volume{Empty{}};
+    volume.allocate(width, height, depth);
+    return volume;
+}
+
+
+
+/**
+ * List the PNG slices of a directory in sorted order and select the requested range.
+ * Exits the program if the directory cannot be read.
+ *
  * @param dirPath The directory path where the images are stored.
- * @param minIndex The minimum index of the images to be loaded. Optional.
- * @param maxIndex The maximum index of the images to be loaded. Optional.
- * 
- * @author Yunjie Li, Ce Huang, Prayush Udas
- * @acknowledgement This function was developed with the assistance of generative AI.
+ * @param minIndex The minimum index of the images to be loaded (1-based), or -1 for the first image.
+ * @param maxIndex The maximum index of the images to be loaded (1-based), or -1 for the last image.
+ * @return The file names of the selected slices, in z order.
  */
-Volume::Volume(const std::string dirPath, int minIndex, int maxIndex){
+std::vector<std::string> Volume::listSlices(const std::string& dirPath, int minIndex, int maxIndex){
     size_t mindex = minIndex;
     size_t mxIndex = maxIndex;
     namespace fs = std::filesystem;
@@ -44,49 +237,90 @@ Volume::Volume(const std::string dirPath, int minIndex, int maxIndex){
     auto beginIt = (mindex > 0 && mindex <= imageFiles.size()) ? std::next(imageFiles.begin(), mindex - 1) : imageFiles.begin();
     auto endIt = (mxIndex > 0 && mxIndex <= imageFiles.size()) ? std::next(imageFiles.begin(), mxIndex) : imageFiles.end();
 
-    // load the first image to get the size and channels
-    if (beginIt != imageFiles.end()) {
-        const auto& firstImageName = beginIt->first;
-        unsigned char* imgData = stbi_load(firstImageName.c_str(), &w, &h, &c, 1); // load as grayscale image
-        if (imgData == nullptr) {
-            std::cerr << "[LOG] Failed to load the image." << std::endl;
-            return;
-        } else {
-            std::cout << "[LOG] Volumes loaded with image size " << w << " x " << h << " with " << c << " channel(s)." << std::endl;
+    std::vector<std::string> selected;
+    for (auto it = beginIt; it != endIt; ++it) {
+        selected.push_back(it->first);
+    }
+    return selected;
+}
+
+/**
+ * @brief Construct a new Volume:: Volume object. Load the images from the directory and store them in one contiguous voxel buffer.
+ * If the path is a file rather than a directory it is opened as a native ".vol" volume instead.
+ * 
+ * @param dirPath The directory path where the images are stored, or the path of a native volume file.
+ * @param minIndex The minimum index of the images to be loaded. Optional.
+ * @param maxIndex The maximum index of the images to be loaded. Optional.
+ * @param threads The number of threads used to decode the slices, 0 for one per hardware thread. Optional.
+ * 
+ * @author Yunjie Li, Ce Huang, Prayush Udas
+ * @acknowledgement This function was developed with the assistance of generative AI.
+ */
+Volume::Volume(const std::string dirPath, int minIndex, int maxIndex, unsigned threads){
+    namespace fs = std::filesystem;
+
+    // a single file is a native volume, which is mapped instead of decoded
+    if (fs::is_regular_file(dirPath)) {
+        try {
+            openNative(dirPath, minIndex, maxIndex);
+        } catch (const std::exception& err) {
+            std::cerr << "[ERROR] General error: " << err.what() << "\n";
+            std::exit(EXIT_FAILURE); // Exit the program on error
         }
-        stbi_image_free(imgData);
+        return;
     }
+    std::vector<std::string> selected = listSlices(dirPath, minIndex, maxIndex);
 
-    // Adjust data vector size based on selected images
-    int selectedImagesCount = std::distance(beginIt, endIt);
-    data.resize(selectedImagesCount+1, std::vector<std::vector<unsigned char>>(h+1, std::vector<unsigned char>(w * c + 1)));
+    // probe the header of the first image to get the size and channels without decoding it
+    if (selected.empty() || !stbi_info(selected.front().c_str(), &w, &h, &c)) {
+        std::cerr << "[LOG] Failed to load the image." << std::endl;
+        allocate(0, 0, 0);
+        return;
+    }
+    std::cout << "[LOG] Volumes loaded with image size " << w << " x " << h << " with " << c << " channel(s)." << std::endl;
 
+    // Allocate one contiguous buffer for the selected images
+    int selectedImagesCount = static_cast<int>(selected.size());
+    allocate(w, h, selectedImagesCount);
+    std::cout << "[LOG] Voxel buffer of " << data.size() / (1024.0 * 1024.0) << " MB allocated." << std::endl;
 
-    // load images and store them in the 3D vector, index starts from 1
-    // check if the size and channels are the same as the first image
-    int index = 1;
-    for (auto it = beginIt; it != endIt; ++it) {
-        const auto& filename = it->first;
-        unsigned char* imgData = stbi_load(filename.c_str(), &w, &h, &c, 1); // Load as grayscale image
-        if (imgData != nullptr) {
-            for (int y = 1; y <= h; ++y) {
-                for (int x = 1; x <= w * c; ++x) {
-                    data[index][y][x] = imgData[((y-1) * w * c) + x-1];
-                }
-            }
-            stbi_image_free(imgData);
+    // decode the images on the worker pool, each one straight into its own slice of the voxel buffer, index starts from 0
+    // a slice that fails to decode is left zeroed and reported below instead of aborting the load
+    std::vector<std::string> failures(selectedImagesCount);
+    ThreadPool pool(threads);
+    pool.parallelFor(0, selectedImagesCount, [&](int index) {
+        int imgW, imgH, imgC;
+        unsigned char* imgData = stbi_load(selected[index].c_str(), &imgW, &imgH, &imgC, 1); // Load as grayscale image
+        if (imgData == nullptr) {
+            failures[index] = stbi_failure_reason();
+            return;
+        }
+        if (imgW != w || imgH != h) {
+            failures[index] = std::format("size {} x {} does not match {} x {}", imgW, imgH, w, h);
         } else {
-            std::cerr << "[ERROR] Failed to load image: " << filename << std::endl;
+            for (int y = 0; y < h; ++y) {
+                std::memcpy(row(y, index), imgData + static_cast<size_t>(y) * w, w);
+            }
+        }
+        stbi_image_free(imgData);
+    });
+
+    int failed = 0;
+    for (int index = 0; index < selectedImagesCount; ++index) {
+        if (!failures[index].empty()) {
+            std::cerr << "[ERROR] Failed to load image: " << selected[index] << " (" << failures[index] << ")" << std::endl;
+            ++failed;
         }
-        ++index;
+    }
+    if (failed > 0) {
+        std::cerr << "[ERROR] " << failed << " of " << selectedImagesCount << " slices failed to load and were left empty." << std::endl;
     }
     std::cout << "[LOG] Selected images loaded." << std::endl;
-
-    this->l = this->data.size()-1;
 }
 
 /**
  * Save the output images after projection to the specified directory.
+ * An unsliced volume saved to a path ending in ".vol" is written in the native volume format instead.
  * 
  * @param filename The filename of the output image.
  * 
@@ -94,12 +328,14 @@ Volume::Volume(const std::string dirPath, int minIndex, int maxIndex){
  */
 void Volume::save(const std::string& filename){
     std::string fname;
-    if(sliced){
+    if(!sliced && std::filesystem::path(filename).extension() == ".vol"){
+        saveNative(filename);
+    }else if(sliced){
         stbi_write_png(filename.c_str(), this->w, this->h, 1, this->slice.data(), 0);
     }else{
-        for (size_t imgIndex = 0; imgIndex < data.size(); ++imgIndex){    
+        for (int imgIndex = 0; imgIndex < l; ++imgIndex){
             fname = std::format("{}/VolImage_{}.png", filename, imgIndex);
-            stbi_write_png(fname.c_str(), this->w, this->h, 1, data[imgIndex].data(), 0);
+            stbi_write_png(fname.c_str(), this->w, this->h, 1, slicePtr(imgIndex), static_cast<int>(yStride));
         }
     }
 }
@@ -108,3 +344,183 @@ Volume::Volume() : w(10), h(10), c(3), l(5) {
    std::cout<<"[LOG] Volumes loaded with size " << w << " x " << h << " with " << c << " channel(s)."<<std::endl;
 }
 
+Volume::Volume(Empty) : w(0), h(0), c(1), l(0) {}
+
+
+/**
+ * Open a native ".vol" file by mapping its voxels. The selected slices are contiguous in the file, so a
+ * sub-range costs nothing more than an offset into the mapping.
+ *
+ * @param filename The native volume file.
+ * @param minIndex The first slice to use (1-based, inclusive), or -1 for the first slice.
+ * @param maxIndex The last slice to use (1-based, inclusive), or -1 for the last slice.
+ */
+void Volume::openNative(const std::string& filename, int minIndex, int maxIndex){
+    VolumeFileHeader header;
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, volumeMagic, sizeof(volumeMagic)) != 0) {
+        throw std::runtime_error(filename + " is not a native volume file");
+    }
+    if (header.version != volumeVersion || header.headerBytes != volumeHeaderBytes || header.voxelType != voxelTypeUint8
+        || header.channels != 1) {
+        throw std::runtime_error(filename + " uses an unsupported version or voxel type");
+    }
+    // every offset into the file is at most the header plus all of the voxels, so that sum must not wrap either
+    size_t sliceBytes = 0, volumeBytes = 0;
+    if (header.w > INT_MAX || header.h > INT_MAX || header.l > INT_MAX || !checkedMultiply(header.w, header.h, sliceBytes)
+        || !checkedMultiply(sliceBytes, header.l, volumeBytes) || volumeBytes > SIZE_MAX - volumeHeaderBytes) {
+        throw std::runtime_error(filename + " has dimensions too large for a volume");
+    }
+
+    int first = (minIndex > 0 && minIndex <= static_cast<int>(header.l)) ? minIndex - 1 : 0;
+    int last = (maxIndex > 0 && maxIndex <= static_cast<int>(header.l)) ? maxIndex : header.l;
+
+    path = filename;
+    w = header.w;
+    h = header.h;
+    c = 1;
+    l = std::max(last - first, 0);
+    xStride = 1;
+    yStride = w;
+    zStride = sliceBytes;
+    std::copy(header.spacing, header.spacing + 3, spacing);
+    cache.reset();
+    data = VoxelBuffer::mapFile(filename, header.headerBytes + static_cast<size_t>(first) * sliceBytes, static_cast<size_t>(l) * sliceBytes);
+    std::cout << "[LOG] Volume mapped with size " << w << " x " << h << " x " << l << " from " << filename << std::endl;
+}
+
+/**
+ * Write the volume in the native ".vol" format. Rows are written without their stride padding.
+ *
+ * @param filename The file to write.
+ */
+void Volume::saveNative(const std::string& filename){
+    std::ofstream file(filename, std::ios::binary);
+    writeNativeHeader(file, *this);
+    for (int z = 0; z < l; ++z) {
+        for (int y = 0; y < h; ++y) {
+            file.write(reinterpret_cast<const char*>(row(y, z)), w);
+        }
+    }
+    if (!file) {
+        std::cerr << "[LOG][VolumeSave] Error in saving file" << std::endl;
+        return;
+    }
+    std::cout << "[LOG][VolumeSave] Volume saved as " << filename << std::endl;
+}
+
+/**
+ * Create a sink that writes each slice it receives straight to disk, so that a filter producing its
+ * output slice by slice never needs the whole result in memory.
+ *
+ * @param filename A ".vol" file to write in the native format, or a directory for VolImage_{z}.png files.
+ * @param like The volume whose dimensions and spacing the output has.
+ * @return The sink; slices must be passed in increasing z.
+ */
+Volume::SliceSink Volume::sliceWriter(const std::string& filename, const Volume& like){
+    int width = like.w;
+    int height = like.h;
+    if (std::filesystem::path(filename).extension() == ".vol") {
+        auto file = std::make_shared<std::ofstream>(filename, std::ios::binary);
+        writeNativeHeader(*file, like);
+        if (!*file) {
+            throw std::runtime_error("cannot write " + filename);
+        }
+        return [file, filename, width, height](int, const unsigned char* pixels) {
+            if (!file->write(reinterpret_cast<const char*>(pixels), static_cast<std::streamsize>(width) * height)) {
+                throw std::runtime_error("cannot write " + filename);
+            }
+        };
+    }
+    return [filename, width, height](int z, const unsigned char* pixels) {
+        std::string fname = std::format("{}/VolImage_{}.png", filename, z);
+        stbi_write_png(fname.c_str(), width, height, 1, pixels, width);
+    };
+}
+
+/**
+ * Convert a directory of PNG slices into a native ".vol" file, so that later runs can map it instead
+ * of decoding every slice again.
+ *
+ * @param dirPath The directory containing the PNG slices.
+ * @param filename The native volume file to write.
+ * @param minIndex The first slice to convert (1-based, inclusive). Optional.
+ * @param maxIndex The last slice to convert (1-based, inclusive). Optional.
+ */
+void Volume::convert(const std::string& dirPath, const std::string& filename, int minIndex, int maxIndex){
+    Volume volume(dirPath, minIndex, maxIndex);
+    volume.saveNative(filename);
+}
+
+/**
+ * Open a directory of PNG slices lazily. Only the header of the first slice is read here; every slice is
+ * decoded the first time it is accessed and kept in an LRU cache of at most `budgetBytes` bytes, so the
+ * existing projection and slicing code can run on the volume through the usual accessors.
+ *
+ * @param dirPath The directory path where the images are stored.
+ * @param budgetBytes The maximum number of bytes of decoded slices to keep in memory.
+ * @param minIndex The minimum index of the images to be used. Optional.
+ * @param maxIndex The maximum index of the images to be used. Optional.
+ * @return A volume whose voxels are read through a SliceCache.
+ */
+Volume Volume::openLazy(const std::string& dirPath, size_t budgetBytes, int minIndex, int maxIndex){
+    Volume volume{Empty{}};
+    std::vector<std::string> selected = listSlices(dirPath, minIndex, maxIndex);
+    volume.path = dirPath;
+    volume.allocate(0, 0, 0);
+    if (selected.empty() || !stbi_info(selected.front().c_str(), &volume.w, &volume.h, &volume.c)) {
+        std::cerr << "[LOG] Failed to load the image." << std::endl;
+        return volume;
+    }
+    volume.c = 1;
+    volume.l = static_cast<int>(selected.size());
+    volume.yStride = volume.w;
+    volume.zStride = 0; // slices live in separate cache entries
+    volume.cache = std::make_shared<SliceCache>(std::move(selected), volume.w, volume.h, budgetBytes);
+    std::cout << "[LOG] Volume opened lazily with size " << volume.w << " x " << volume.h << " x " << volume.l
+              << " and a " << budgetBytes / (1024.0 * 1024.0) << " MB slice cache." << std::endl;
+    return volume;
+}
+
+/**
+ * Open a volume for one pass over its slices, such as a projection, keeping as little of it in memory as
+ * possible. PNG slices are read through a cache of two slices: the one being processed and the next one,
+ * which the projections decode ahead on another thread. A native volume is mapped, so its slices are paged
+ * in from the file as they are read and can be dropped again by the kernel.
+ *
+ * @param path A directory of PNG slices or a native ".vol" file.
+ * @param minIndex The minimum index of the slices to be used. Optional.
+ * @param maxIndex The maximum index of the slices to be used. Optional.
+ * @return A lazy or mapped volume.
+ */
+Volume Volume::openStream(const std::string& path, int minIndex, int maxIndex){
+    if (std::filesystem::is_regular_file(path)) {
+        return Volume(path, minIndex, maxIndex);
+    }
+    int width = 0, height = 0, channels = 0;
+    std::vector<std::string> selected = listSlices(path, minIndex, maxIndex);
+    if (!selected.empty()) {
+        stbi_info(selected.front().c_str(), &width, &height, &channels);
+    }
+    return openLazy(path, 2 * static_cast<size_t>(width) * height, minIndex, maxIndex);
+}
+
+/**
+ * Decode every slice of a lazily opened volume into an ordinary voxel buffer and drop the cache.
+ * Needed before modifying the voxels, since writes to a cached slice are lost when it is evicted.
+ * Does nothing for a volume that is already in memory.
+ */
+void Volume::materialize(){
+    if (!cache) {
+        return;
+    }
+    std::shared_ptr<SliceCache> source = std::move(cache);
+    cache.reset();
+    allocate(w, h, l);
+    for (int z = 0; z < l; ++z) {
+        const unsigned char* pixels = source->slice(z);
+        for (int y = 0; y < h; ++y) {
+            std::memcpy(row(y, z), pixels + static_cast<size_t>(y) * w, w);
+        }
+    }
+}
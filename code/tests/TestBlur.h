@@ -2,7 +2,11 @@
 #define TESTBLUR_H
 
 #include "TestColour.h"
+#include "Convolution.h"
+#include "ConvolutionKernels.h"
 #include "stringColours.h"
+#include "test_helpers.h"
+#include <numeric>
 
 /**
  * @brief Tests the applyMedianBlurMultiChannel function for its ability to apply a median blur to each channel of a multi-channel image.
@@ -70,6 +74,37 @@ void testApplyMedianBlurMultiChannel() {
     std::cout<<"\n";
 }
 
+/**
+ * @brief Tests that the running-histogram median blur gives exactly the median of every edge-replicated window.
+ *
+ * Random images with 1, 3 and 4 channels are filtered with odd and even kernels, a kernel larger than the image and one
+ * whose window holds more than 65535 pixels, and compared with the middle element of each sorted window. One image has
+ * only four grey levels, so that most windows contain long runs of equal values.
+*/
+void testHistogramMedianBlur(){
+    Blur blur;
+    try {
+        struct Case { int width, height, channels, kernelSize, levels; };
+        for (Case test : {Case{31, 23, 1, 1, 256}, Case{31, 23, 3, 3, 256}, Case{40, 17, 4, 4, 256}, Case{25, 19, 3, 15, 256},
+                          Case{33, 21, 1, 7, 4}, Case{12, 9, 1, 41, 256}, Case{10, 8, 1, 257, 256}}) {
+            std::vector<unsigned char> pixels = randomPixels(test.width, test.height, test.channels, test.kernelSize, test.levels,
+                                                             255 / std::max(test.levels - 1, 1));
+            int side = 2 * (test.kernelSize / 2) + 1;
+            std::vector<unsigned char> expected = windowReference(pixels, test.width, test.height, test.channels, side, side, windowMedian);
+
+            BorrowedImage image(pixels, test.width, test.height, test.channels);
+            blur.apply(Blur::Median, image, test.kernelSize);
+            if (pixels != expected) {
+                throw std::runtime_error("Median blur differs from the median of the window.");
+            }
+        }
+        std::cout << COL_GREEN << "[TEST] Histogram median blur test passed: output matches the sorted windows." << COL_NORMAL << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << COL_RED << "[TEST] Exception caught during histogram median blur test: " << e.what() << COL_NORMAL << std::endl;
+    }
+    std::cout<<"\n";
+}
+
 /**
  * @brief Tests the applyBoxBlur function to ensure it correctly applies a box blur filter to an image.
  *
@@ -133,6 +168,37 @@ void testApplyBoxBlur() {
     std::cout<<"\n";
 }
 
+/**
+ * @brief Tests that the running-sum box blur gives exactly the mean of every edge-replicated window.
+ *
+ * Non-square random images with 1, 3 and 4 channels are filtered with odd and even kernels, one as large as the image
+ * and one larger, and compared with the rounded-down mean of each window summed directly.
+*/
+void testRunningSumBoxBlur(){
+    Blur blur;
+    try {
+        struct Case { int width, height, channels, kernelSize; };
+        for (Case test : {Case{37, 21, 1, 3}, Case{21, 37, 3, 7}, Case{30, 19, 4, 6}, Case{25, 16, 3, 25}, Case{9, 14, 1, 41}}) {
+            std::vector<unsigned char> pixels = randomPixels(test.width, test.height, test.channels, test.kernelSize);
+            int side = 2 * (test.kernelSize / 2) + 1;
+            std::vector<unsigned char> expected = windowReference(pixels, test.width, test.height, test.channels, side, side,
+                [](const std::vector<unsigned char>& window) {
+                    return static_cast<unsigned char>(std::accumulate(window.begin(), window.end(), 0) / static_cast<int>(window.size()));
+                });
+
+            BorrowedImage image(pixels, test.width, test.height, test.channels);
+            blur.apply(Blur::Box, image, test.kernelSize);
+            if (pixels != expected) {
+                throw std::runtime_error("Box blur differs from the mean of the window.");
+            }
+        }
+        std::cout << COL_GREEN << "[TEST] Running-sum box blur test passed: output matches the window means." << COL_NORMAL << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << COL_RED << "[TEST] Exception caught during running-sum box blur test: " << e.what() << COL_NORMAL << std::endl;
+    }
+    std::cout<<"\n";
+}
+
 /**
  * @brief Tests the applyGaussianBlur function to verify its ability to apply a Gaussian blur to an image.
  *
@@ -189,6 +255,259 @@ void testApplyGaussianBlur() {
     std::cout<<"\n";
 }
 
+/**
+ * @brief Tests that the separable Gaussian blur stays within 1 of the full 2D kernel.
+ *
+ * Random images with 1, 3 and 4 channels are blurred with kernels from 3 to 31 pixels, including one larger than the
+ * image, and compared with a direct kernelSize x kernelSize convolution that clamps at the border like the original
+ * implementation did.
+*/
+void testSeparableGaussianBlur(){
+    Blur blur;
+    try {
+        struct Case { int width, height, channels, kernelSize; float sigma; };
+        for (Case test : {Case{67, 45, 1, 3, 1.0f}, Case{67, 45, 3, 5, 1.0f}, Case{53, 61, 4, 15, 3.0f},
+                          Case{40, 33, 3, 31, 6.0f}, Case{9, 6, 3, 15, 4.0f}}) {
+            std::vector<unsigned char> pixels = randomPixels(test.width, test.height, test.channels, test.kernelSize);
+
+            // reference: the full 2D kernel, clamped at the border
+            int offset = test.kernelSize / 2;
+            std::vector<float> kernel((2 * offset + 1) * (2 * offset + 1));
+            float sum = 0.0f;
+            for (int ky = -offset; ky <= offset; ++ky) {
+                for (int kx = -offset; kx <= offset; ++kx) {
+                    float value = std::exp(-(kx * kx + ky * ky) / (2 * test.sigma * test.sigma));
+                    kernel[(ky + offset) * (2 * offset + 1) + kx + offset] = value;
+                    sum += value;
+                }
+            }
+            std::vector<unsigned char> expected = windowReference(pixels, test.width, test.height, test.channels, 2 * offset + 1, 2 * offset + 1,
+                [&](const std::vector<unsigned char>& window) {
+                    float total = 0.0f;
+                    for (size_t i = 0; i < window.size(); ++i) {
+                        total += kernel[i] / sum * window[i];
+                    }
+                    return static_cast<unsigned char>(std::clamp(static_cast<int>(total), 0, 255));
+                });
+
+            BorrowedImage image(pixels, test.width, test.height, test.channels);
+            blur.apply(Blur::Gaussian, image, test.kernelSize, test.sigma);
+            if (maxDifference(pixels, expected) > 1) {
+                throw std::runtime_error("Separable Gaussian blur differs from the 2D kernel by more than 1.");
+            }
+        }
+        std::cout << COL_GREEN << "[TEST] Separable Gaussian blur test passed: output within 1 of the 2D kernel." << COL_NORMAL << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << COL_RED << "[TEST] Exception caught during separable Gaussian blur test: " << e.what() << COL_NORMAL << std::endl;
+    }
+    std::cout<<"\n";
+}
+
+/**
+ * @brief Tests the recursive Gaussian mode against an exact Gaussian.
+ *
+ * Random images are blurred with sigma from 3 to 40 in Recursive mode and compared with a double-precision
+ * convolution over +-5 sigma that clamps at the border: the mean error must stay below half a grey level and no pixel
+ * may be off by more than 3. A constant image must come back unchanged, which checks the border initialisation.
+*/
+void testRecursiveGaussianBlur(){
+    Blur blur;
+    try {
+        struct Case { int width, height, channels; float sigma; };
+        for (Case test : {Case{83, 61, 1, 3.0f}, Case{64, 75, 3, 12.0f}, Case{120, 90, 4, 40.0f}, Case{9, 7, 3, 25.0f}}) {
+            int values = test.width * test.height * test.channels;
+            std::vector<unsigned char> pixels = randomPixels(test.width, test.height, test.channels, static_cast<int>(test.sigma));
+
+            // reference: the separable Gaussian in double precision, too wide for a brute-force window
+            int radius = static_cast<int>(std::ceil(5.0f * test.sigma));
+            std::vector<double> kernel(2 * radius + 1);
+            double total = 0.0;
+            for (int i = -radius; i <= radius; ++i) {
+                kernel[i + radius] = std::exp(-(i * i) / (2.0 * test.sigma * test.sigma));
+                total += kernel[i + radius];
+            }
+            std::vector<double> rows(values);
+            for (int y = 0; y < test.height; ++y) {
+                for (int x = 0; x < test.width; ++x) {
+                    for (int channel = 0; channel < test.channels; ++channel) {
+                        double sum = 0.0;
+                        for (int i = -radius; i <= radius; ++i) {
+                            sum += kernel[i + radius] / total * pixels[(y * test.width + std::clamp(x + i, 0, test.width - 1)) * test.channels + channel];
+                        }
+                        rows[(y * test.width + x) * test.channels + channel] = sum;
+                    }
+                }
+            }
+            std::vector<double> expected(values);
+            for (int y = 0; y < test.height; ++y) {
+                for (int x = 0; x < test.width; ++x) {
+                    for (int channel = 0; channel < test.channels; ++channel) {
+                        double sum = 0.0;
+                        for (int i = -radius; i <= radius; ++i) {
+                            sum += kernel[i + radius] / total * rows[(std::clamp(y + i, 0, test.height - 1) * test.width + x) * test.channels + channel];
+                        }
+                        expected[(y * test.width + x) * test.channels + channel] = sum;
+                    }
+                }
+            }
+
+            BorrowedImage image(pixels, test.width, test.height, test.channels);
+            blur.apply(Blur::Gaussian, image, 3, test.sigma, Blur::Recursive);
+            double error = 0.0;
+            for (int i = 0; i < values; ++i) {
+                double difference = std::abs(pixels[i] - expected[i]);
+                error += difference;
+                if (difference > 3.0) {
+                    throw std::runtime_error("Recursive Gaussian blur is more than 3 grey levels from the exact Gaussian.");
+                }
+            }
+            if (error / values > 0.5) {
+                throw std::runtime_error("Recursive Gaussian blur is on average more than half a grey level from the exact Gaussian.");
+            }
+
+            std::fill(pixels.begin(), pixels.end(), 173);
+            blur.apply(Blur::Gaussian, image, 3, test.sigma, Blur::Recursive);
+            if (std::any_of(pixels.begin(), pixels.end(), [](unsigned char value) { return value != 173; })) {
+                throw std::runtime_error("Recursive Gaussian blur changed a constant image.");
+            }
+        }
+        std::cout << COL_GREEN << "[TEST] Recursive Gaussian blur test passed: output close to the exact Gaussian." << COL_NORMAL << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << COL_RED << "[TEST] Exception caught during recursive Gaussian blur test: " << e.what() << COL_NORMAL << std::endl;
+    }
+    std::cout<<"\n";
+}
+
+/**
+ * @brief Tests the fixed-point convolution engine against the same kernels in double precision.
+ *
+ * A general 5 x 3 kernel with negative weights, an even 4 x 2 kernel, two separable Gaussians and a box wider than
+ * the image are applied to random images with 1 and 3 channels and compared with a double-precision convolution that
+ * clamps at the border and rounds to nearest: no pixel may be off by more than 1. Every kernel sums to one, so a
+ * constant image must come back unchanged, which checks the rounded weights still sum exactly to unity. Every
+ * instruction set must give the same output as the scalar kernels.
+*/
+void testFixedPointConvolution(){
+    ConvolutionKernels::Isa original = ConvolutionKernels::activeIsa();
+    try {
+        // each kernel with its weights in double precision; separable ones list the weights along one axis
+        struct Kernel { Convolution convolution; std::vector<double> weights; int width, height; };
+        std::vector<double> general = {-0.05, -0.1, -0.15, -0.1, -0.05, 0.05, 0.2, 1.4, 0.2, 0.05, -0.05, -0.1, -0.15, -0.1, -0.05};
+        std::vector<double> even = {0.1, 0.2, 0.3, 0.1, 0.05, 0.1, 0.1, 0.05};
+        std::vector<Kernel> kernels = {
+            {Convolution(std::vector<float>(general.begin(), general.end()), 5, 3), general, 5, 3},
+            {Convolution(std::vector<float>(even.begin(), even.end()), 4, 2), even, 4, 2},
+            {Convolution::box(61), std::vector<double>(61, 1.0 / 61.0), 61, 61},
+        };
+        for (auto [kernelSize, sigma] : {std::pair{7, 1.5f}, std::pair{25, 5.0f}}) {
+            std::vector<double> weights(kernelSize);
+            double total = 0.0;
+            for (int i = 0; i < kernelSize; ++i) {
+                weights[i] = std::exp(-((i - kernelSize / 2) * (i - kernelSize / 2)) / (2.0 * sigma * sigma));
+                total += weights[i];
+            }
+            for (double& weight : weights) {
+                weight /= total;
+            }
+            kernels.push_back({Convolution::gaussian(kernelSize, sigma), weights, kernelSize, kernelSize});
+        }
+
+        for (const Kernel& kernel : kernels) {
+            auto weightAt = [&](int kx, int ky) {
+                return kernel.convolution.separable ? kernel.weights[kx] * kernel.weights[ky] : kernel.weights[ky * kernel.width + kx];
+            };
+            for (int channels : {1, 3}) {
+                int width = 67, height = 23;
+                std::vector<unsigned char> pixels = randomPixels(width, height, channels, kernel.width * channels);
+                std::vector<unsigned char> expected = windowReference(pixels, width, height, channels, kernel.width, kernel.height,
+                    [&](const std::vector<unsigned char>& window) {
+                        double sum = 0.0;
+                        for (int ky = 0; ky < kernel.height; ++ky) {
+                            for (int kx = 0; kx < kernel.width; ++kx) {
+                                sum += weightAt(kx, ky) * window[ky * kernel.width + kx];
+                            }
+                        }
+                        return static_cast<unsigned char>(std::clamp(std::lround(sum), 0L, 255L));
+                    });
+
+                std::vector<unsigned char> scalar;
+                for (ConvolutionKernels::Isa isa : {ProjectionKernels::Scalar, ProjectionKernels::SSE2, ProjectionKernels::AVX2}) {
+                    if (ConvolutionKernels::select(isa) != isa) {
+                        continue; // not supported by this CPU
+                    }
+                    std::vector<unsigned char> result = pixels;
+                    BorrowedImage image(result, width, height, channels);
+                    kernel.convolution.apply(image);
+                    if (isa == ProjectionKernels::Scalar) {
+                        scalar = result;
+                    } else if (result != scalar) {
+                        throw std::runtime_error("Convolution kernels for instruction set " + std::to_string(isa) + " differ from the scalar kernels.");
+                    }
+                    if (maxDifference(result, expected) > 1) {
+                        throw std::runtime_error("Fixed-point convolution differs from the double-precision kernel by more than 1.");
+                    }
+                }
+
+                std::vector<unsigned char> flat(pixels.size(), 173);
+                BorrowedImage image(flat, width, height, channels);
+                kernel.convolution.apply(image);
+                if (std::any_of(flat.begin(), flat.end(), [](unsigned char value) { return value != 173; })) {
+                    throw std::runtime_error("Fixed-point convolution changed a constant image.");
+                }
+            }
+        }
+        std::cout << COL_GREEN << "[TEST] Fixed-point convolution test passed: output within 1 of the exact kernels." << COL_NORMAL << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << COL_RED << "[TEST] Exception caught during fixed-point convolution test: " << e.what() << COL_NORMAL << std::endl;
+    }
+    ConvolutionKernels::select(original);
+    std::cout<<"\n";
+}
+
+/**
+ * @brief Tests that the tiled, multi-threaded image filters do not depend on the number of threads.
+ *
+ * Images wide enough to be split into several column tiles are filtered with Median, Box, Gaussian and the recursive
+ * Gaussian by a Blur on one thread and a Blur on seven, which cut the image into different tiles and bands; the
+ * outputs must be identical. The median across tile boundaries is also checked against the sorted windows.
+*/
+void testTiledBlur(){
+    try {
+        Blur serial(1), threaded(7);
+        struct Case { int width, height, channels; };
+        for (Case test : {Case{300, 97, 3}, Case{517, 40, 1}}) {
+            std::vector<unsigned char> pixels = randomPixels(test.width, test.height, test.channels, test.width);
+
+            auto filtered = [&](Blur& blur, auto filter) {
+                std::vector<unsigned char> result = pixels;
+                BorrowedImage image(result, test.width, test.height, test.channels);
+                filter(blur, image);
+                return result;
+            };
+            std::vector<std::function<void(Blur&, Image&)>> filters = {
+                [](Blur& blur, Image& image) { blur.apply(Blur::Median, image, 5); },
+                [](Blur& blur, Image& image) { blur.apply(Blur::Median, image, 41); },
+                [](Blur& blur, Image& image) { blur.apply(Blur::Box, image, 9); },
+                [](Blur& blur, Image& image) { blur.apply(Blur::Gaussian, image, 15, 3.0f); },
+                [](Blur& blur, Image& image) { blur.apply(Blur::Gaussian, image, 3, 20.0f, Blur::Recursive); },
+            };
+            for (const auto& filter : filters) {
+                if (filtered(serial, filter) != filtered(threaded, filter)) {
+                    throw std::runtime_error("Blur on seven threads differs from the same blur on one thread.");
+                }
+            }
+
+            if (filtered(threaded, filters[0]) != windowReference(pixels, test.width, test.height, test.channels, 5, 5, windowMedian)) {
+                throw std::runtime_error("Tiled median blur differs from the median of the window.");
+            }
+        }
+        std::cout << COL_GREEN << "[TEST] Tiled blur test passed: output is the same on one and seven threads." << COL_NORMAL << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << COL_RED << "[TEST] Exception caught during tiled blur test: " << e.what() << COL_NORMAL << std::endl;
+    }
+    std::cout<<"\n";
+}
+
 /**
  * @brief Tests the applyGaussianBlurToVolume function to verify its ability to apply a Gaussian blur to a set of image.
  *
@@ -210,23 +529,17 @@ void testApplyGaussianBlurToVolume(){
     int kernelSize = 3;
     float sigma = 2.0f;
     
-    std::vector<std::vector<std::vector<unsigned char>>> zero_volume_data(depth+1, std::vector<std::vector<unsigned char>>(height+1, std::vector<unsigned char>(width+1, 0)));
-    std::vector<std::vector<std::vector<unsigned char>>> unit_volume_data(depth+1, std::vector<std::vector<unsigned char>>(height+1, std::vector<unsigned char>(width+1, 1)));
-    
     Blur blur;
     
     // Test with a zero volume to ensure the output is also zero
     try {
         Volume zero_volume;
-        zero_volume.data = zero_volume_data;
-        zero_volume.w = width;
-        zero_volume.h = height;
-        zero_volume.l = depth;
+        zero_volume.allocate(width, height, depth);
         blur.apply(blur.Gaussian, zero_volume, kernelSize, sigma);
         for (int z = 0; z < depth; ++z) {
             for (int y = 0; y < height; ++y) {
                 for (int x = 0; x < width; ++x) {
-                    if (zero_volume.data[z][y][x] != 0) {
+                    if (zero_volume.at(x, y, z) != 0) {
                         throw std::runtime_error(std::string(COL_RED) + "[TEST] Zero input test failed: Volume was not all zeros after applying 3D Gaussian blur." + std::string(COL_NORMAL));
                     }
                 }
@@ -241,12 +554,10 @@ void testApplyGaussianBlurToVolume(){
     // Test with a unit volume to ensure the output is also blurred
     try {
         Volume unit_volume;
-        unit_volume.data = unit_volume_data;
-        unit_volume.w = width;
-        unit_volume.h = height;
-        unit_volume.l = depth;
+        unit_volume.allocate(width, height, depth);
+        std::fill(unit_volume.data.data(), unit_volume.data.data() + unit_volume.data.size(), 1);
         blur.apply(blur.Gaussian, unit_volume, kernelSize, sigma);
-        if (unit_volume.data[depth/2+1][height/2+1][width/2+1] != 1) {
+        if (unit_volume.at(width/2, height/2, depth/2) != 1) {
             throw std::runtime_error(std::string(COL_RED) + "Unit input test failed: Volume was not blurred as expected after applying 3D Gaussian blur." + COL_NORMAL);
         }
         std::cout << COL_GREEN << "[TEST] Unit input test passed: Volume was blurred as expected after applying 3D Gaussian blur." << COL_NORMAL << std::endl;
@@ -267,10 +578,10 @@ void testApplyGaussianBlurToVolume(){
  */
 int countNoiseNum(const Volume& volume, int threshold) {
     int count = 0;
-    for (int z = 1; z <= volume.l; ++z) {
-        for (int y = 1; y <= volume.h; ++y) {
-            for (int x = 1; x <= volume.w; ++x) {
-                if (volume.data[z][y][x] < 128 - threshold || volume.data[z][y][x] > 128 + threshold) {
+    for (int z = 0; z < volume.l; ++z) {
+        for (int y = 0; y < volume.h; ++y) {
+            for (int x = 0; x < volume.w; ++x) {
+                if (volume.at(x, y, z) < 128 - threshold || volume.at(x, y, z) > 128 + threshold) {
                     count++;
                 }
             }
@@ -301,23 +612,17 @@ void testApplyMedianBlurToVolume(){
     int width = 10, height = 10, depth = 10;
     int kernelSize = 3;
     
-    std::vector<std::vector<std::vector<unsigned char>>> zero_volume_data(depth+1, std::vector<std::vector<unsigned char>>(height+1, std::vector<unsigned char>(width+1, 0)));
-    std::vector<std::vector<std::vector<unsigned char>>> const_volume_data(depth+1, std::vector<std::vector<unsigned char>>(height+1, std::vector<unsigned char>(width+1, 128)));
-    
     Blur blur;
     
     // Test with a zero volume to ensure the output is also zero
     try {
         Volume zero_volume;
-        zero_volume.data = zero_volume_data;
-        zero_volume.w = width;
-        zero_volume.h = height;
-        zero_volume.l = depth;
+        zero_volume.allocate(width, height, depth);
         blur.apply(blur.Median, zero_volume, kernelSize);
         for (int z = 0; z < depth; ++z) {
             for (int y = 0; y < height; ++y) {
                 for (int x = 0; x < width; ++x) {
-                    if (zero_volume.data[z][y][x] != 0) {
+                    if (zero_volume.at(x, y, z) != 0) {
                         throw std::runtime_error(std::string(COL_RED) + "[TEST] Zero input test failed: Volume was not all zeros after applying 3D Median blur." + COL_NORMAL);
 
                     }
@@ -333,18 +638,16 @@ void testApplyMedianBlurToVolume(){
     // Test with a constant volume, with some noise added, to ensure the noise is reduced
     try {
         Volume const_volume;
-        const_volume.data = const_volume_data;
-        const_volume.w = width;
-        const_volume.h = height;
-        const_volume.l = depth;
+        const_volume.allocate(width, height, depth);
+        std::fill(const_volume.data.data(), const_volume.data.data() + const_volume.data.size(), 128);
 
         std::srand(std::time(nullptr)); // Seed the random number generator
         for(int i = 0; i < 300; ++i) {
-            int z = std::rand() % const_volume.l + 1;
-            int y = std::rand() % const_volume.h + 1;
-            int x = std::rand() % const_volume.w + 1;
+            int z = std::rand() % const_volume.l;
+            int y = std::rand() % const_volume.h;
+            int x = std::rand() % const_volume.w;
             // Add or subtract 30 to the pixel value with 50% probability
-            const_volume.data[z][y][x] = std::rand() % 2 == 0 ? std::min(255, const_volume.data[z][y][x] + 30) : std::max(0, const_volume.data[z][y][x] - 30);
+            const_volume.at(x, y, z) = std::rand() % 2 == 0 ? std::min(255, const_volume.at(x, y, z) + 30) : std::max(0, const_volume.at(x, y, z) - 30);
         }
         
         int beforeNoiseNum = countNoiseNum(const_volume, 10);
@@ -362,4 +665,125 @@ void testApplyMedianBlurToVolume(){
     }
 }
 
+/**
+ * @brief Tests that the bricked 3D filters produce exactly the same volume as the slice-major ones.
+ *
+ * A random volume whose dimensions are not multiples of the brick size is blurred with both layouts,
+ * so bricks clipped at the volume edges and halos crossing brick boundaries are both exercised.
+*/
+void testBrickedVolumeBlur(){
+    int width = 45, height = 37, depth = 35;
+    Blur blur;
+    try {
+        Volume source;
+        source.allocate(width, height, depth);
+        std::srand(7);
+        for (int z = 0; z < depth; ++z) {
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    source.at(x, y, z) = std::rand() % 256;
+                }
+            }
+        }
+
+        for (Blur::type filter : {Blur::Gaussian, Blur::Median}) {
+            Volume sliceMajor = source;
+            Volume bricked = source;
+            if (filter == Blur::Gaussian) {
+                blur.apply(filter, sliceMajor, 5, 2.0f);
+                blur.apply(filter, bricked, 5, 2.0f, Blur::Bricked);
+            } else {
+                blur.apply(filter, sliceMajor, 3);
+                blur.apply(filter, bricked, 3, Blur::Bricked);
+            }
+            for (int z = 0; z < depth; ++z) {
+                for (int y = 0; y < height; ++y) {
+                    for (int x = 0; x < width; ++x) {
+                        if (sliceMajor.at(x, y, z) != bricked.at(x, y, z)) {
+                            throw std::runtime_error("Bricked 3D blur differs from the slice-major result.");
+                        }
+                    }
+                }
+            }
+        }
+        std::cout << COL_GREEN << "[TEST] Bricked 3D blur test passed: output matches the slice-major filters." << COL_NORMAL << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << COL_RED << "[TEST] Exception caught during bricked 3D blur test: " << e.what() << COL_NORMAL << std::endl;
+    }
+}
+
+/**
+ * @brief Tests that the streaming 3D filters emit the same slices as the in-memory ones.
+ *
+ * Gaussian and median output is collected through a callback sink and compared with apply(); the
+ * Gaussian result is also written through Volume::sliceWriter and read back as a native volume.
+*/
+void testStreamingVolumeBlur(){
+    int width = 23, height = 19, depth = 9;
+    Blur blur;
+    try {
+        Volume source;
+        source.allocate(width, height, depth);
+        std::srand(11);
+        for (int z = 0; z < depth; ++z) {
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    source.at(x, y, z) = std::rand() % 256;
+                }
+            }
+        }
+
+        for (Blur::type filter : {Blur::Gaussian, Blur::Median}) {
+            Volume expected = source;
+            Volume streamed = source;
+            int emitted = 0;
+            auto sink = [&](int z, const unsigned char* pixels) {
+                if (z != emitted++) {
+                    throw std::runtime_error("Streaming blur emitted slices out of order.");
+                }
+                for (int y = 0; y < height; ++y) {
+                    std::copy_n(pixels + y * width, width, streamed.row(y, z));
+                }
+            };
+            if (filter == Blur::Gaussian) {
+                blur.apply(filter, expected, 5, 1.5f);
+                blur.applyStreaming(filter, source, 5, 1.5f, sink);
+            } else {
+                blur.apply(filter, expected, 3);
+                blur.applyStreaming(filter, source, 3, sink);
+            }
+            if (emitted != depth) {
+                throw std::runtime_error("Streaming blur did not emit every slice.");
+            }
+            for (int z = 0; z < depth; ++z) {
+                for (int y = 0; y < height; ++y) {
+                    for (int x = 0; x < width; ++x) {
+                        if (expected.at(x, y, z) != streamed.at(x, y, z)) {
+                            throw std::runtime_error("Streaming 3D blur differs from the in-memory result.");
+                        }
+                    }
+                }
+            }
+
+            if (filter == Blur::Gaussian) {
+                std::string filename = (std::filesystem::temp_directory_path() / "acs_streaming_blur_test.vol").string();
+                blur.applyStreaming(filter, source, 5, 1.5f, Volume::sliceWriter(filename, source));
+                Volume written(filename, -1, -1);
+                for (int z = 0; z < depth; ++z) {
+                    for (int y = 0; y < height; ++y) {
+                        if (!std::equal(expected.row(y, z), expected.row(y, z) + width, written.row(y, z))) {
+                            std::filesystem::remove(filename);
+                            throw std::runtime_error("Streamed .vol output differs from the in-memory result.");
+                        }
+                    }
+                }
+                std::filesystem::remove(filename);
+            }
+        }
+        std::cout << COL_GREEN << "[TEST] Streaming 3D blur test passed: output matches the in-memory filters." << COL_NORMAL << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << COL_RED << "[TEST] Exception caught during streaming 3D blur test: " << e.what() << COL_NORMAL << std::endl;
+    }
+}
+
 #endif // TESTBLUR_H
\ No newline at end of file
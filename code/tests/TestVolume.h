@@ -1,5 +1,7 @@
 #include "Volume.h"
 #include "Image.h"
+#include "Projection.h"
+#include "Slice.h"
 #include "stringColours.h"
 
 /**
@@ -28,4 +30,84 @@ void testVolume(){
         std::cerr << COL_RED "[TEST] Exception caught during Volume test: " << e.what() << COL_NORMAL << std::endl;
         return; // Exit the test on exception
     }
-}
\ No newline at end of file
+}
+/**
+ * @brief Test the native ".vol" format, checking that a volume saved with Volume::save maps back with the
+ * same dimensions, spacing and voxels, and that a slice range selects the right part of the file.
+*/
+void testNativeVolume(){
+    const int width = 70, height = 6, depth = 5;
+    std::string filename = (std::filesystem::temp_directory_path() / "test_native_volume.vol").string();
+    try {
+        Volume volume;
+        volume.allocate(width, height, depth);
+        volume.spacing[2] = 2.5f;
+        for (int z = 0; z < depth; ++z) {
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    volume.at(x, y, z) = static_cast<unsigned char>(x + y * 3 + z * 40);
+                }
+            }
+        }
+        volume.save(filename);
+
+        Volume mapped(filename, 2, 4);
+        if (mapped.w != width || mapped.h != height || mapped.l != 3 || mapped.spacing[2] != 2.5f) {
+            throw std::runtime_error("[TEST] Native volume test failed: header does not match the saved volume");
+        }
+        for (int z = 0; z < mapped.l; ++z) {
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    if (mapped.at(x, y, z) != volume.at(x, y, z + 1)) {
+                        throw std::runtime_error("[TEST] Native volume test failed: voxels do not match the saved volume");
+                    }
+                }
+            }
+        }
+        std::cout << COL_GREEN << "[TEST] Native volume test passed." << COL_NORMAL << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << COL_RED << e.what() << COL_NORMAL << std::endl;
+    }
+    std::filesystem::remove(filename);
+}
+
+/**
+ * @brief Test lazily opened volumes, checking that projections and slices through the slice cache give the
+ * same result as an eagerly loaded volume, that only touched slices are decoded, and that the cache stays
+ * within its byte budget.
+*/
+void testLazyVolume(){
+    std::string folderPath = "../code/tests/testimagesfor3d/";
+    try {
+        Volume eager(folderPath, -1, -1);
+        size_t sliceBytes = static_cast<size_t>(eager.w) * eager.h;
+        Volume lazy = Volume::openLazy(folderPath, sliceBytes); // room for a single slice
+
+        if (lazy.w != eager.w || lazy.h != eager.h || lazy.l != eager.l || lazy.sliceCache()->decodedCount() != 0) {
+            throw std::runtime_error("[TEST] Lazy volume test failed: opening the volume decoded slices or got the wrong size");
+        }
+        lazy.at(0, 0, 1);
+        if (lazy.sliceCache()->decodedCount() != 1) {
+            throw std::runtime_error("[TEST] Lazy volume test failed: touching one slice did not decode exactly one slice");
+        }
+
+        Projection projection;
+        projection.apply(Projection::Proj::projMIP, eager);
+        projection.apply(Projection::Proj::projMIP, lazy);
+        if (lazy.slice != eager.slice) {
+            throw std::runtime_error("[TEST] Lazy volume test failed: MIP differs from the eagerly loaded volume");
+        }
+        Slice slicer;
+        slicer.sliceXZ(eager, eager.h / 2);
+        slicer.sliceXZ(lazy, lazy.h / 2);
+        if (lazy.slice != eager.slice) {
+            throw std::runtime_error("[TEST] Lazy volume test failed: XZ slice differs from the eagerly loaded volume");
+        }
+        if (lazy.sliceCache()->residentBytes() > sliceBytes) {
+            throw std::runtime_error("[TEST] Lazy volume test failed: slice cache exceeded its budget");
+        }
+        std::cout << COL_GREEN << "[TEST] Lazy volume test passed." << COL_NORMAL << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << COL_RED << e.what() << COL_NORMAL << std::endl;
+    }
+}
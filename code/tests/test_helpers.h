@@ -0,0 +1,130 @@
+#ifndef TEST_HELPERS
+#define TEST_HELPERS
+
+#include "Image.h"
+#include "Volume.h"
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+// the 3D test data, relative to the directory the tests run from
+const std::string testVolumePath = "../code/tests/testimagesfor3d/";
+
+/**
+ * @brief A width x height x depth volume of random voxels, the same for the same seed.
+ *
+ * @param seed The seed passed to std::srand before the voxels are drawn.
+ * @param levels The number of distinct values; voxel values are (std::rand() % levels) * step.
+ * @param step The spacing between the values, so that few levels can still span the 8-bit range.
+ */
+Volume randomVolume(int width, int height, int depth, unsigned seed, int levels = 256, int step = 1) {
+    Volume volume = Volume::allocated(width, height, depth);
+    std::srand(seed);
+    for (int z = 0; z < depth; ++z) {
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                volume.at(x, y, z) = static_cast<unsigned char>(std::rand() % levels * step);
+            }
+        }
+    }
+    return volume;
+}
+
+/**
+ * @brief The 3D test data loaded into memory, and opened lazily with a cache of a single slice, so that every
+ * access pattern of the lazy volume has to refetch slices.
+ */
+struct LoadedAndLazy {
+    Volume loaded, lazy;
+};
+
+LoadedAndLazy loadedAndLazy() {
+    Volume loaded(testVolumePath, -1, -1);
+    size_t sliceBytes = static_cast<size_t>(loaded.w) * loaded.h;
+    return {std::move(loaded), Volume::openLazy(testVolumePath, sliceBytes)};
+}
+
+/**
+ * @brief The interleaved pixels of a random width x height image with `channels` channels, the same for the same seed.
+ *
+ * @param seed The seed passed to std::srand before the pixels are drawn.
+ * @param levels The number of distinct values; pixel values are (std::rand() % levels) * step.
+ * @param step The spacing between the values.
+ */
+std::vector<unsigned char> randomPixels(int width, int height, int channels, unsigned seed, int levels = 256, int step = 1) {
+    std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * channels);
+    std::srand(seed);
+    for (unsigned char& value : pixels) {
+        value = static_cast<unsigned char>(std::rand() % levels * step);
+    }
+    return pixels;
+}
+
+/**
+ * @brief An Image whose pixels are borrowed from a vector, so a filter can run on test pixels in place. The pointer is
+ * cleared before the Image is destroyed, since the vector owns the memory.
+ */
+struct BorrowedImage : Image {
+    BorrowedImage(std::vector<unsigned char>& pixels, int width, int height, int channels) {
+        w = width;
+        h = height;
+        c = channels;
+        data = pixels.data();
+    }
+    ~BorrowedImage() { data = nullptr; }
+    BorrowedImage(const BorrowedImage&) = delete;
+    BorrowedImage& operator=(const BorrowedImage&) = delete;
+};
+
+/**
+ * @brief The brute-force reference for a filter over a window around every pixel, with rows and columns outside the
+ * image clamped to the edge. The window is windowWidth x windowHeight pixels of one channel, anchored at
+ * (windowWidth / 2, windowHeight / 2) and passed to `reduce` row by row; `reduce` returns the expected output and may
+ * reorder the window.
+ *
+ * @return The expected output of every pixel and channel, interleaved like `pixels`.
+ */
+template <typename Reduce>
+auto windowReference(const std::vector<unsigned char>& pixels, int width, int height, int channels, int windowWidth,
+                     int windowHeight, Reduce reduce) {
+    std::vector<unsigned char> window(static_cast<size_t>(windowWidth) * windowHeight);
+    std::vector<decltype(reduce(window))> expected(pixels.size());
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            for (int channel = 0; channel < channels; ++channel) {
+                for (int ky = 0; ky < windowHeight; ++ky) {
+                    for (int kx = 0; kx < windowWidth; ++kx) {
+                        int nx = std::clamp(x + kx - windowWidth / 2, 0, width - 1);
+                        int ny = std::clamp(y + ky - windowHeight / 2, 0, height - 1);
+                        window[ky * windowWidth + kx] = pixels[(static_cast<size_t>(ny) * width + nx) * channels + channel];
+                    }
+                }
+                expected[(static_cast<size_t>(y) * width + x) * channels + channel] = reduce(window);
+            }
+        }
+    }
+    return expected;
+}
+
+/**
+ * @brief The middle element of a window, as a median filter computes it.
+ */
+unsigned char windowMedian(std::vector<unsigned char>& window) {
+    std::nth_element(window.begin(), window.begin() + window.size() / 2, window.end());
+    return window[window.size() / 2];
+}
+
+/**
+ * @brief The largest absolute difference between two images of the same size.
+ */
+int maxDifference(const std::vector<unsigned char>& a, const std::vector<unsigned char>& b) {
+    int largest = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        largest = std::max(largest, std::abs(a[i] - b[i]));
+    }
+    return largest;
+}
+
+#endif
@@ -10,8 +10,16 @@ int main(){
     
     std::cout << COL_MAGENTA << "[TEST] Testing blur..." << COL_NORMAL << std::endl;
     testApplyMedianBlurMultiChannel();
+    testHistogramMedianBlur();
     testApplyBoxBlur();
+    testRunningSumBoxBlur();
     testApplyGaussianBlur();
+    testSeparableGaussianBlur();
+    testRecursiveGaussianBlur();
+    testFixedPointConvolution();
+    testTiledBlur();
+    testBrickedVolumeBlur();
+    testStreamingVolumeBlur();
 
     std::cout << COL_MAGENTA << "[TEST] Testing edge detection..." << COL_NORMAL << std::endl;
     testSobel();
@@ -23,9 +31,26 @@ int main(){
     testApplyMIP();
     testApplyAIP();
     testApplyMinIP();
+    testApplyFused();
+    testProjectionKernels();
+    testThreadedProjection();
+    testProjectionAxes();
+    testSlabIndex();
+    testRayCaster();
+    testPercentileProjection();
+    testStreamingProjection();
+    testProjectionDepth();
 
     std::cout << COL_MAGENTA << "[TEST] Testing slicing..." << COL_NORMAL << std::endl;
     testSlice();
+    testObliqueSlice();
+    testCurvedSlice();
+    testReorient();
+    testSliceViews();
+
+    std::cout << COL_MAGENTA << "[TEST] Testing volume..." << COL_NORMAL << std::endl;
+    testNativeVolume();
+    testLazyVolume();
 
 
 
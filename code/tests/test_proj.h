@@ -2,7 +2,11 @@
 #define TEST_PROJ
 
 #include "Projection.h"
+#include "ProjectionKernels.h"
+#include "SlabIndex.h"
+#include "RayCaster.h"
 #include "stringColours.h"
+#include "test_helpers.h"
 
 /**
  * @brief Tests the Maximum Intensity Projection (MIP) application on a volumetric dataset.
@@ -26,18 +30,15 @@
 void testApplyMIP() {
     int depth = 5, width = 10, height = 10;
     Volume volume;
-    volume.w = width;
-    volume.h = height;
-    volume.l = depth;
-    volume.data.resize(depth + 1, std::vector<std::vector<unsigned char>>(height + 1, std::vector<unsigned char>(width + 1)));
+    volume.allocate(width, height, depth);
 
     std::cout << "[LOG] Applying MIP with volume dimensions: " << depth << "x" << height << "x" << width << std::endl;
 
     // Fill in the test data
-    for (int z = 1; z <= depth; ++z) {
-        for (int y = 1; y <= height; ++y) {
-            for (int x = 1; x <= width; ++x) {
-                volume.data[z][y][x] = (unsigned char)(x + y + z * 10);
+    for (int z = 0; z < depth; ++z) {
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                volume.at(x, y, z) = (unsigned char)(x + y + z * 10);
             }
         }
     }
@@ -48,12 +49,12 @@ void testApplyMIP() {
     projection.apply(Projection::Proj::projMIP, volume);
 
     bool testPassed = true;
-    for (int y = 1; y <= height; ++y) {
-        for (int x = 1; x <= width; ++x) {
-            unsigned char expectedMax = (unsigned char)(x + y + depth * 10);
-            if (volume.slice[(y-1) * width + (x-1)] != expectedMax) {
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            unsigned char expectedMax = (unsigned char)(x + y + (depth - 1) * 10);
+            if (volume.slice[y * width + x] != expectedMax) {
                 std::cerr << "MIP test failed at (" << x << ", " << y << "). Expected: "
-                          << (int)expectedMax << ", Got: " << (int)volume.slice[(y-1) * width + (x-1)] << std::endl;
+                          << (int)expectedMax << ", Got: " << (int)volume.slice[y * width + x] << std::endl;
                 testPassed = false;
                 break;
             }
@@ -90,17 +91,14 @@ void testApplyMIP() {
 void testApplyAIP() {
     int depth = 5, width = 10, height = 10;
     Volume volume; 
-    volume.w = width;
-    volume.h = height;
-    volume.l = depth;
-    volume.data.resize(depth + 1, std::vector<std::vector<unsigned char>>(height + 1, std::vector<unsigned char>(width + 1)));
+    volume.allocate(width, height, depth);
 
     std::cout << "[LOG] Applying AIP with volume dimensions: " << depth << "x" << height << "x" << width << std::endl;
 
-    for (int z = 1; z <= depth; ++z) {
-        for (int y = 1; y <= height; ++y) {
-            for (int x = 1; x <= width; ++x) {
-                volume.data[z][y][x] = (unsigned char)(x + y + z * 10);
+    for (int z = 0; z < depth; ++z) {
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                volume.at(x, y, z) = (unsigned char)(x + y + z * 10);
             }
         }
     }
@@ -109,16 +107,16 @@ void testApplyAIP() {
     projection.apply(Projection::Proj::projAIP, volume);
 
     bool testPassed = true;
-    for (int y = 1; y <= height; ++y) {
-        for (int x = 1; x <= width; ++x) {
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
             unsigned int sumIntensity = 0;
-            for (int z = 1; z <= depth; ++z) {
-                sumIntensity += volume.data[z][y][x];
+            for (int z = 0; z < depth; ++z) {
+                sumIntensity += volume.at(x, y, z);
             }
             unsigned char expectedAvg = static_cast<unsigned char>(sumIntensity / depth);
-            if (volume.slice[(y-1) * width + (x-1)] != expectedAvg) {
+            if (volume.slice[y * width + x] != expectedAvg) {
                 std::cerr << "AIP test failed at (" << x << ", " << y << "). Expected: "
-                          << (int)expectedAvg << ", Got: " << (int)volume.slice[(y-1) * width + (x-1)] << std::endl;
+                          << (int)expectedAvg << ", Got: " << (int)volume.slice[y * width + x] << std::endl;
                 testPassed = false;
                 break;
             }
@@ -156,17 +154,14 @@ void testApplyAIP() {
 void testApplyMinIP() {
     int depth = 5, width = 10, height = 10;
     Volume volume; 
-    volume.w = width;
-    volume.h = height;
-    volume.l = depth;
-    volume.data.resize(depth + 1, std::vector<std::vector<unsigned char>>(height + 1, std::vector<unsigned char>(width + 1)));
+    volume.allocate(width, height, depth);
 
     std::cout << "[LOG] Applying MinIP with volume dimensions: " << depth << "x" << height << "x" << width << std::endl;
 
-    for (int z = 1; z <= depth; ++z) {
-        for (int y = 1; y <= height; ++y) {
-            for (int x = 1; x <= width; ++x) {
-                volume.data[z][y][x] = (unsigned char)(x + y + z * 10); 
+    for (int z = 0; z < depth; ++z) {
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                volume.at(x, y, z) = (unsigned char)(x + y + z * 10); 
             }
         }
     }
@@ -175,18 +170,18 @@ void testApplyMinIP() {
     projection.apply(Projection::Proj::projMinIP, volume);
 
     bool testPassed = true;
-    for (int y = 1; y <= height; ++y) {
-        for (int x = 1; x <= width; ++x) {
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
             unsigned char expectedMin = 255;
-            for (int z = 1; z <= depth; ++z) {
+            for (int z = 0; z < depth; ++z) {
                 unsigned char intensity = (unsigned char)(x + y + z * 10);
                 if (intensity < expectedMin) {
                     expectedMin = intensity;
                 }
             }
-            if (volume.slice[(y-1) * width + (x-1)] != expectedMin) {
+            if (volume.slice[y * width + x] != expectedMin) {
                 std::cerr << "MinIP test failed at (" << x << ", " << y << "). Expected: "
-                          << (int)expectedMin << ", Got: " << (int)volume.slice[(y-1) * width + (x-1)] << std::endl;
+                          << (int)expectedMin << ", Got: " << (int)volume.slice[y * width + x] << std::endl;
                 testPassed = false;
                 break;
             }
@@ -202,4 +197,415 @@ void testApplyMinIP() {
 }
 
 
+/**
+ * @brief Tests the fused projection against the individual projections.
+ *
+ * Every projection is requested at once from a volume whose intensities along z are known, so the fused MIP, MinIP and AIP
+ * must equal the results of apply(), and the standard deviation of x + y + {0, 10, 20, 30, 40} is sqrt(200), rounded to 14.
+ */
+void testApplyFused() {
+    int depth = 5, width = 10, height = 10;
+    Volume volume;
+    volume.allocate(width, height, depth);
+    for (int z = 0; z < depth; ++z) {
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                volume.at(x, y, z) = (unsigned char)(x + y + z * 10);
+            }
+        }
+    }
+
+    Projection projection;
+    auto results = projection.applyFused({Projection::projMIP, Projection::projMinIP, Projection::projAIP, Projection::projStdDev}, volume);
+
+    bool testPassed = results.size() == 4;
+    for (Projection::Proj method : {Projection::projMIP, Projection::projMinIP, Projection::projAIP}) {
+        Volume single = volume;
+        projection.apply(method, single);
+        if (results[method] != single.slice) {
+            std::cerr << "Fused projection " << method << " differs from apply()." << std::endl;
+            testPassed = false;
+        }
+    }
+    for (unsigned char deviation : results[Projection::projStdDev]) {
+        if (deviation != 14) {
+            std::cerr << "Fused standard deviation projection expected 14, got " << (int)deviation << std::endl;
+            testPassed = false;
+            break;
+        }
+    }
+    if (testPassed) {
+        std::cout << COL_GREEN << "[TEST] Fused projection test passed.\n" << COL_NORMAL << std::endl;
+    } else {
+        std::cerr << COL_RED << "[TEST] Fused projection test failed.\n" << COL_NORMAL << std::endl;
+    }
+}
+
+
+/**
+ * @brief Tests that every SIMD projection kernel gives the same result as the scalar one.
+ *
+ * A random volume whose width is not a multiple of any vector width is projected along every axis with each instruction
+ * set the CPU supports, so the vector loops, their scalar tails and the horizontal reductions are all compared against
+ * the scalar kernels.
+ */
+void testProjectionKernels() {
+    int depth = 13, width = 203, height = 7;
+    Volume volume = randomVolume(width, height, depth, 3);
+
+    std::vector<Projection::Proj> methods = {Projection::projMIP, Projection::projMinIP, Projection::projAIP, Projection::projStdDev};
+    Projection projection;
+    ProjectionKernels::Isa original = ProjectionKernels::activeIsa();
+    bool testPassed = true;
+    for (Projection::Axis axis : {Projection::axisX, Projection::axisY, Projection::axisZ}) {
+        ProjectionKernels::select(ProjectionKernels::Scalar);
+        auto expected = projection.applyFused(methods, volume, axis);
+        for (ProjectionKernels::Isa isa : {ProjectionKernels::SSE2, ProjectionKernels::AVX2, ProjectionKernels::AVX512}) {
+            if (ProjectionKernels::select(isa) != isa) {
+                continue; // not supported by this CPU
+            }
+            if (projection.applyFused(methods, volume, axis) != expected) {
+                std::cerr << "Projection kernels for instruction set " << isa << " differ from the scalar kernels." << std::endl;
+                testPassed = false;
+            }
+        }
+    }
+    ProjectionKernels::select(original);
+
+    if (testPassed) {
+        std::cout << COL_GREEN << "[TEST] Projection kernel test passed.\n" << COL_NORMAL << std::endl;
+    } else {
+        std::cerr << COL_RED << "[TEST] Projection kernel test failed.\n" << COL_NORMAL << std::endl;
+    }
+}
+
+
+/**
+ * @brief Tests that multi-threaded projections match single-threaded ones exactly.
+ *
+ * A random in-memory volume and a lazily loaded volume with room for a single cached slice are projected with one and
+ * with four threads. The row bands must reproduce the serial result bit for bit, including AIP rounding, and the lazy
+ * volume must not lose slices to eviction while several threads are reading it.
+ */
+void testThreadedProjection() {
+    int depth = 11, width = 37, height = 53;
+    Volume volume = randomVolume(width, height, depth, 5);
+
+    std::vector<Projection::Proj> methods = {Projection::projMIP, Projection::projMinIP, Projection::projAIP, Projection::projStdDev};
+    Projection serial(1);
+    Projection threaded(4);
+    bool testPassed = serial.applyFused(methods, volume) == threaded.applyFused(methods, volume);
+    for (Projection::Proj method : methods) {
+        Volume serialVolume = volume;
+        Volume threadedVolume = volume;
+        serial.apply(method, serialVolume);
+        threaded.apply(method, threadedVolume);
+        testPassed = testPassed && serialVolume.slice == threadedVolume.slice;
+    }
+
+    auto [loaded, lazy] = loadedAndLazy();
+    testPassed = testPassed && serial.applyFused(methods, loaded) == threaded.applyFused(methods, lazy);
+
+    if (testPassed) {
+        std::cout << COL_GREEN << "[TEST] Threaded projection test passed.\n" << COL_NORMAL << std::endl;
+    } else {
+        std::cerr << COL_RED << "[TEST] Threaded projection test failed.\n" << COL_NORMAL << std::endl;
+    }
+}
+
+
+/**
+ * @brief Tests projections along the x and y axes against a direct voxel-by-voxel reference.
+ *
+ * Every method is computed along each axis for a random volume, with an in-memory volume on four threads and, for the
+ * axes that walk a lazy volume differently, with a lazily loaded volume holding a single slice.
+ */
+void testProjectionAxes() {
+    int depth = 6, width = 45, height = 29;
+    Volume volume = randomVolume(width, height, depth, 9);
+
+    std::vector<Projection::Proj> methods = {Projection::projMIP, Projection::projMinIP, Projection::projAIP, Projection::projStdDev};
+    Projection projection(4);
+    bool testPassed = true;
+    for (Projection::Axis axis : {Projection::axisX, Projection::axisY, Projection::axisZ}) {
+        int outWidth, outHeight;
+        Projection::outputSize(volume, axis, outWidth, outHeight);
+        int n = axis == Projection::axisX ? width : (axis == Projection::axisY ? height : depth);
+        auto results = projection.applyFused(methods, volume, axis);
+        for (int row = 0; row < outHeight; ++row) {
+            for (int column = 0; column < outWidth; ++column) {
+                int maximum = 0, minimum = 255;
+                unsigned long long sum = 0, sumSquares = 0;
+                for (int k = 0; k < n; ++k) {
+                    int value = axis == Projection::axisX ? volume.at(k, column, row)
+                              : axis == Projection::axisY ? volume.at(column, k, row)
+                                                          : volume.at(column, row, k);
+                    maximum = std::max(maximum, value);
+                    minimum = std::min(minimum, value);
+                    sum += value;
+                    sumSquares += value * value;
+                }
+                double deviation = std::sqrt(static_cast<double>(n * sumSquares - sum * sum)) / n;
+                size_t pixel = static_cast<size_t>(row) * outWidth + column;
+                if (results[Projection::projMIP][pixel] != maximum || results[Projection::projMinIP][pixel] != minimum
+                    || results[Projection::projAIP][pixel] != sum / n || results[Projection::projStdDev][pixel] != std::lround(deviation)) {
+                    testPassed = false;
+                }
+            }
+        }
+        Volume single = volume;
+        projection.apply(Projection::projMIP, single, axis);
+        testPassed = testPassed && single.slice == results[Projection::projMIP];
+    }
+
+    auto [loaded, lazy] = loadedAndLazy();
+    for (Projection::Axis axis : {Projection::axisX, Projection::axisY}) {
+        testPassed = testPassed && Projection(1).applyFused(methods, loaded, axis) == projection.applyFused(methods, lazy, axis);
+    }
+
+    if (testPassed) {
+        std::cout << COL_GREEN << "[TEST] Projection axis test passed.\n" << COL_NORMAL << std::endl;
+    } else {
+        std::cerr << COL_RED << "[TEST] Projection axis test failed.\n" << COL_NORMAL << std::endl;
+    }
+}
+
+
+/**
+ * @brief Tests slab projections from a SlabIndex against projecting the slab as a volume of its own.
+ *
+ * Every slab [z0, z1] of a random volume is checked for MIP, MinIP and AIP. Small blocks are used so slabs inside one
+ * block, across two blocks and across many blocks (with runs of whole blocks of every length) are all covered. The
+ * default index must hold MIP only, and AIP must stay exact on a white volume with blocks larger than its 16-bit
+ * offsets allow.
+ */
+void testSlabIndex() {
+    int depth = 37, width = 19, height = 11;
+    Volume volume = randomVolume(width, height, depth, 13);
+
+    SlabIndex index(volume, {Projection::projMIP, Projection::projMinIP, Projection::projAIP}, 4);
+    Projection projection(1);
+    bool testPassed = true;
+    Volume slab;
+    for (int z0 = 1; z0 <= depth && testPassed; ++z0) {
+        for (int z1 = z0; z1 <= depth && testPassed; ++z1) {
+            slab.allocate(width, height, z1 - z0 + 1);
+            for (int z = z0; z <= z1; ++z) {
+                for (int y = 0; y < height; ++y) {
+                    std::copy_n(volume.row(y, z - 1), width, slab.row(y, z - z0));
+                }
+            }
+            auto expected = projection.applyFused({Projection::projMIP, Projection::projMinIP, Projection::projAIP}, slab);
+            for (Projection::Proj method : {Projection::projMIP, Projection::projMinIP, Projection::projAIP}) {
+                if (index.project(method, z0, z1) != expected[method]) {
+                    std::cerr << "Slab projection " << method << " over [" << z0 << ", " << z1 << "] is wrong." << std::endl;
+                    testPassed = false;
+                }
+            }
+        }
+    }
+
+    // the default index holds MIP only
+    SlabIndex mipOnly(volume);
+    testPassed = testPassed && mipOnly.project(Projection::projMIP, 3, 30) == index.project(Projection::projMIP, 3, 30);
+    try {
+        mipOnly.project(Projection::projAIP, 3, 30);
+        testPassed = false;
+    } catch (const std::invalid_argument&) {
+    }
+
+    // AIP blocks are capped at 257 slices so that the 16-bit offsets of a white volume cannot overflow
+    Volume white;
+    white.allocate(3, 2, 600);
+    for (int z = 0; z < white.l; ++z) {
+        for (int y = 0; y < white.h; ++y) {
+            std::fill_n(white.row(y, z), white.w, 255);
+        }
+    }
+    SlabIndex whiteIndex(white, {Projection::projAIP}, 1000);
+    for (auto [z0, z1] : {std::pair{1, 600}, std::pair{200, 520}, std::pair{258, 258}}) {
+        std::vector<unsigned char> average = whiteIndex.project(Projection::projAIP, z0, z1);
+        testPassed = testPassed && std::all_of(average.begin(), average.end(), [](unsigned char v) { return v == 255; });
+    }
+
+    if (testPassed) {
+        std::cout << COL_GREEN << "[TEST] Slab index test passed.\n" << COL_NORMAL << std::endl;
+    } else {
+        std::cerr << COL_RED << "[TEST] Slab index test failed.\n" << COL_NORMAL << std::endl;
+    }
+}
+
+
+/**
+ * @brief Tests the ray-cast projector against the axis-aligned projections.
+ *
+ * Looking straight down z with one-voxel pixels and steps, every ray samples voxel centres, so MIP and MinIP must match
+ * the z projections exactly and the rounded AIP must be within one of the truncated one. Turning the view 90 degrees
+ * about y must give the x projection, mirrored along z, and the first frame of a rotation sequence must be the
+ * unrotated view.
+ */
+void testRayCaster() {
+    int depth = 9, width = 15, height = 12;
+    Volume volume = randomVolume(width, height, depth, 17);
+
+    Projection projection(1);
+    bool testPassed = true;
+    RayCaster axial(width, height, 1.0f, 2);
+    axial.pixelSize = 1.0f;
+    auto zProjections = projection.applyFused({Projection::projMIP, Projection::projMinIP, Projection::projAIP}, volume);
+    testPassed = testPassed && axial.render(Projection::projMIP, volume, Rotation::identity()) == zProjections[Projection::projMIP];
+    testPassed = testPassed && axial.render(Projection::projMinIP, volume, Rotation::identity()) == zProjections[Projection::projMinIP];
+    std::vector<unsigned char> average = axial.render(Projection::projAIP, volume, Rotation::identity());
+    for (size_t i = 0; i < average.size(); ++i) {
+        testPassed = testPassed && std::abs(average[i] - zProjections[Projection::projAIP][i]) <= 1;
+    }
+
+    RayCaster sagittal(depth, height, 1.0f, 2);
+    sagittal.pixelSize = 1.0f;
+    std::vector<unsigned char> side = sagittal.render(Projection::projMIP, volume, Rotation::about(Projection::axisY, 90.0f));
+    std::vector<unsigned char> xProjection = projection.applyFused({Projection::projMIP}, volume, Projection::axisX)[Projection::projMIP];
+    for (int y = 0; y < height; ++y) {
+        for (int i = 0; i < depth; ++i) {
+            testPassed = testPassed && side[y * depth + i] == xProjection[(depth - 1 - i) * height + y];
+        }
+    }
+
+    auto frames = axial.renderRotation(Projection::projMIP, volume, 4);
+    testPassed = testPassed && frames.size() == 4 && frames[0] == zProjections[Projection::projMIP];
+
+    if (testPassed) {
+        std::cout << COL_GREEN << "[TEST] Ray caster test passed.\n" << COL_NORMAL << std::endl;
+    } else {
+        std::cerr << COL_RED << "[TEST] Ray caster test failed.\n" << COL_NORMAL << std::endl;
+    }
+}
+
+
+/**
+ * @brief Tests percentile projections against sorting every column of the volume.
+ *
+ * Random volumes with an odd and an even number of slices and few distinct values (so bins repeat) are checked at several
+ * percentiles on four threads. The 0th and 100th percentiles must match MinIP and MIP, the median projection must match the
+ * 50th percentile, and a lazily loaded volume must give the same median as the loaded one.
+ */
+void testPercentileProjection() {
+    int width = 23, height = 17;
+    Projection projection(4);
+    bool testPassed = true;
+    for (int depth : {9, 12}) {
+        Volume volume = randomVolume(width, height, depth, 17 + depth, 6, 50);
+        for (float percentile : {0.0f, 10.0f, 25.0f, 50.0f, 62.5f, 90.0f, 100.0f}) {
+            std::vector<unsigned char> result = projection.applyPercentile(percentile, volume);
+            double position = percentile / 100.0 * (depth - 1);
+            int lower = static_cast<int>(position);
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    std::vector<int> column;
+                    for (int z = 0; z < depth; ++z) {
+                        column.push_back(volume.at(x, y, z));
+                    }
+                    std::sort(column.begin(), column.end());
+                    int upper = column[std::min(lower + 1, depth - 1)];
+                    long expected = std::lround(column[lower] + (position - lower) * (upper - column[lower]));
+                    testPassed = testPassed && result[y * width + x] == expected;
+                }
+            }
+        }
+        auto extremes = projection.applyFused({Projection::projMIP, Projection::projMinIP}, volume);
+        testPassed = testPassed && projection.applyPercentile(0.0f, volume) == extremes[Projection::projMinIP];
+        testPassed = testPassed && projection.applyPercentile(100.0f, volume) == extremes[Projection::projMIP];
+        Volume median = volume;
+        projection.apply(Projection::projMedian, median);
+        testPassed = testPassed && median.slice == projection.applyPercentile(50.0f, volume);
+    }
+
+    auto [loaded, lazy] = loadedAndLazy();
+    testPassed = testPassed && Projection(1).applyPercentile(50.0f, loaded) == projection.applyPercentile(50.0f, lazy);
+
+    if (testPassed) {
+        std::cout << COL_GREEN << "[TEST] Percentile projection test passed.\n" << COL_NORMAL << std::endl;
+    } else {
+        std::cerr << COL_RED << "[TEST] Percentile projection test failed.\n" << COL_NORMAL << std::endl;
+    }
+}
+
+
+/**
+ * @brief Tests projecting a volume opened for streaming against projecting the fully loaded volume.
+ *
+ * Every axis and the median must give the same images, each slice must be decoded exactly once per pass, and no more
+ * than two slices may be held at any time.
+ */
+void testStreamingProjection() {
+    std::vector<Projection::Proj> methods = {Projection::projMIP, Projection::projMinIP, Projection::projAIP, Projection::projStdDev};
+    Volume loaded(testVolumePath, -1, -1);
+    Projection projection(4);
+    bool testPassed = true;
+    for (Projection::Axis axis : {Projection::axisX, Projection::axisY, Projection::axisZ}) {
+        Volume stream = Volume::openStream(testVolumePath);
+        testPassed = testPassed && stream.isLazy() && stream.sliceCache()->capacitySlices() == 2;
+        testPassed = testPassed && projection.applyFused(methods, stream, axis) == Projection(1).applyFused(methods, loaded, axis);
+        testPassed = testPassed && stream.sliceCache()->decodedCount() == stream.l;
+        testPassed = testPassed && stream.sliceCache()->residentBytes() <= 2 * static_cast<size_t>(stream.w) * stream.h;
+    }
+    Volume stream = Volume::openStream(testVolumePath, 2, 3);
+    Volume part(testVolumePath, 2, 3);
+    testPassed = testPassed && stream.l == 2 && projection.applyPercentile(50.0f, stream) == projection.applyPercentile(50.0f, part);
+
+    if (testPassed) {
+        std::cout << COL_GREEN << "[TEST] Streaming projection test passed.\n" << COL_NORMAL << std::endl;
+    } else {
+        std::cerr << COL_RED << "[TEST] Streaming projection test failed.\n" << COL_NORMAL << std::endl;
+    }
+}
+
+
+/**
+ * @brief Tests MIP and MinIP depth maps against scanning every column for the first slice holding its extreme.
+ *
+ * The volume has more than 256 slices, a width that leaves a scalar tail after every vector width, and few distinct
+ * values so that ties are common. Every instruction set must give the same images as apply and the same depth maps.
+ */
+void testProjectionDepth() {
+    int depth = 300, width = 203, height = 5;
+    Volume volume = randomVolume(width, height, depth, 21, 16, 17);
+
+    Projection projection(4);
+    ProjectionKernels::Isa original = ProjectionKernels::activeIsa();
+    bool testPassed = true;
+    for (Projection::Proj method : {Projection::projMIP, Projection::projMinIP}) {
+        Volume reference = volume;
+        projection.apply(method, reference);
+        for (ProjectionKernels::Isa isa : {ProjectionKernels::Scalar, ProjectionKernels::SSE2, ProjectionKernels::AVX2, ProjectionKernels::AVX512}) {
+            if (ProjectionKernels::select(isa) != isa) {
+                continue; // not supported by this CPU
+            }
+            std::vector<uint16_t> depthMap;
+            testPassed = testPassed && projection.applyWithDepth(method, volume, depthMap) == reference.slice;
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    int first = 0;
+                    while (volume.at(x, y, first) != reference.slice[y * width + x]) {
+                        ++first;
+                    }
+                    testPassed = testPassed && depthMap[y * width + x] == first;
+                }
+            }
+        }
+    }
+    ProjectionKernels::select(original);
+
+    auto [loaded, lazy] = loadedAndLazy();
+    std::vector<uint16_t> loadedDepth, lazyDepth;
+    testPassed = testPassed && projection.applyWithDepth(Projection::projMIP, loaded, loadedDepth) == projection.applyWithDepth(Projection::projMIP, lazy, lazyDepth);
+    testPassed = testPassed && loadedDepth == lazyDepth;
+
+    if (testPassed) {
+        std::cout << COL_GREEN << "[TEST] Projection depth map test passed.\n" << COL_NORMAL << std::endl;
+    } else {
+        std::cerr << COL_RED << "[TEST] Projection depth map test failed.\n" << COL_NORMAL << std::endl;
+    }
+}
+
+
 #endif
@@ -2,7 +2,12 @@
 #define TEST_SLICE
 
 #include "Slice.h"
+#include "Blur.h"
+#include "ColourFilter.h"
+#include "EdgeDetection.h"
+#include "test_helpers.h"
 #include <stdexcept>
+#include <cmath>
 
 /**
  * @brief Tests the Slice generation from a volumetric dataset.
@@ -31,15 +36,12 @@ void testSlice() {
 
     // Create a volume with known intensity values
     Volume volume;
-    volume.w = width;
-    volume.h = height;
-    volume.l = depth;
-    volume.data.resize(depth + 1, std::vector<std::vector<unsigned char>>(height + 1, std::vector<unsigned char>(width + 1)));
-
-    for (int z = 1; z <= depth; ++z) {
-        for (int y = 1; y <= height; ++y) {
-            for (int x = 1; x <= width; ++x) {
-                volume.data[z][y][x] = static_cast<unsigned char>(x + y + (z-1) * 10); // Assigning intensity values
+    volume.allocate(width, height, depth);
+
+    for (int z = 0; z < depth; ++z) {
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                volume.at(x, y, z) = static_cast<unsigned char>(x + y + z * 10); // Assigning intensity values
             }
         }
     }
@@ -79,4 +81,274 @@ void testSlice() {
 }
 
 
+/**
+ * @brief Tests oblique reslicing against the axis-aligned slices and against a linear intensity ramp.
+ *
+ * Planes perpendicular to z, y and x must reproduce the XY slice, sliceXZ and sliceYZ exactly with both nearest and trilinear
+ * sampling. On a volume whose intensity is a linear function of position, trilinear sampling is exact, so every pixel of a
+ * tilted plane must round the ramp at its position. A lazily loaded volume must give the same image as the loaded one.
+ */
+void testObliqueSlice() {
+    const int width = 20, height = 16, depth = 12;
+    Volume volume;
+    volume.allocate(width, height, depth);
+    for (int z = 0; z < depth; ++z) {
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                volume.at(x, y, z) = static_cast<unsigned char>(2 * x + 3 * y + 5 * z);
+            }
+        }
+    }
+
+    Slice slicer;
+    bool testPassed = true;
+    auto matches = [&](const Image& image, const std::vector<unsigned char>& expected) {
+        bool same = static_cast<size_t>(image.w) * image.h == expected.size() && std::equal(expected.begin(), expected.end(), image.data);
+        delete[] image.data;
+        return same;
+    };
+    float cx = (width - 1) / 2.0f, cy = (height - 1) / 2.0f, cz = (depth - 1) / 2.0f;
+    for (Slice::Sampling sampling : {Slice::Nearest, Slice::Trilinear}) {
+        std::vector<unsigned char> axial;
+        for (int y = 0; y < height; ++y) {
+            axial.insert(axial.end(), volume.row(y, 4), volume.row(y, 4) + width);
+        }
+        testPassed = testPassed && matches(slicer.sliceOblique(volume, {cx, cy, 4.0f}, {0.0f, 0.0f, 1.0f}, width, height, sampling), axial);
+        Volume copy = volume;
+        slicer.sliceXZ(copy, 6);
+        testPassed = testPassed && matches(slicer.sliceOblique(volume, {cx, 5.0f, cz}, {0.0f, 2.0f, 0.0f}, width, depth, sampling), copy.slice);
+        slicer.sliceYZ(copy, 8);
+        testPassed = testPassed && matches(slicer.sliceOblique(volume, {7.0f, cy, cz}, {-1.0f, 0.0f, 0.0f}, height, depth, sampling), copy.slice);
+    }
+
+    // a normal of (0, 1, 1) gives x across the image and (0, 1, -1) / sqrt(2) down it
+    int size = 9;
+    Image tilted = slicer.sliceOblique(volume, {cx, cy, cz}, {0.0f, 1.0f, 1.0f}, size, size, Slice::Trilinear);
+    for (int j = 0; j < size; ++j) {
+        for (int i = 0; i < size; ++i) {
+            double x = cx + (i - 4), y = cy + (j - 4) / std::sqrt(2.0), z = cz - (j - 4) / std::sqrt(2.0);
+            if (x < 0 || x > width - 1 || y < 0 || y > height - 1 || z < 0 || z > depth - 1) {
+                continue;
+            }
+            testPassed = testPassed && std::abs(tilted.data[j * size + i] - (2 * x + 3 * y + 5 * z)) <= 0.5 + 1e-3;
+        }
+    }
+    delete[] tilted.data;
+
+    auto [loaded, lazy] = loadedAndLazy();
+    std::array<float, 3> centre = {loaded.w / 2.0f, loaded.h / 2.0f, 1.0f}, normal = {0.3f, -0.2f, 1.0f};
+    Image fromLazy = slicer.sliceOblique(lazy, centre, normal, 64, 48);
+    Image fromLoaded = slicer.sliceOblique(loaded, centre, normal, 64, 48);
+    testPassed = testPassed && matches(fromLazy, std::vector<unsigned char>(fromLoaded.data, fromLoaded.data + 64 * 48));
+    delete[] fromLoaded.data;
+
+    if (testPassed) {
+        std::cout << COL_GREEN << "[TEST] Oblique slice test passed." << COL_NORMAL << std::endl << std::endl;
+    } else {
+        std::cerr << COL_RED << "[TEST] Oblique slice test failed." << COL_NORMAL << std::endl << std::endl;
+    }
+}
+
+
+/**
+ * @brief Tests curved planar reformation along polyline and spline paths.
+ *
+ * A straight path down z must give exactly the XZ slice through it, whether it is a polyline or a spline through
+ * collinear points. On a volume whose values are linear in position, every row of a path with a bend must be centred
+ * on the point one pixel further along the path than the row before, and symmetric about it. A lazily loaded volume
+ * must give the same result as the loaded one.
+ */
+void testCurvedSlice() {
+    Slice slicer;
+    bool testPassed = true;
+
+    const int width = 41, height = 29, depth = 17;
+    Volume volume = randomVolume(width, height, depth, 19);
+    Volume view = volume;
+    slicer.sliceXZ(view, 12);
+    Image straight = slicer.sliceCurved(volume, {{20, 11, 0}, {20, 11, 16}}, width);
+    Image spline = slicer.sliceCurved(volume, {{20, 11, 0}, {20, 11, 4}, {20, 11, 8}, {20, 11, 12}, {20, 11, 16}}, width, Slice::Spline);
+    testPassed = straight.w == width && straight.h == depth && spline.w == width && spline.h == depth;
+    testPassed = testPassed && std::equal(view.slice.begin(), view.slice.end(), straight.data);
+    testPassed = testPassed && std::equal(view.slice.begin(), view.slice.end(), spline.data);
+    delete[] straight.data;
+    delete[] spline.data;
+
+    // f = 3x + 2y + 5z, which trilinear interpolation reproduces exactly
+    Volume linear;
+    linear.allocate(24, 20, 16);
+    for (int z = 0; z < 16; ++z) {
+        for (int y = 0; y < 20; ++y) {
+            for (int x = 0; x < 24; ++x) {
+                linear.at(x, y, z) = static_cast<unsigned char>(3 * x + 2 * y + 5 * z);
+            }
+        }
+    }
+    Image bent = slicer.sliceCurved(linear, {{4, 4, 2}, {4, 4, 10}, {16, 10, 10}}, 9);
+    float bend = std::sqrt(144.0f + 36.0f);
+    testPassed = testPassed && bent.w == 9 && bent.h == static_cast<int>(8.0f + bend) + 1;
+    for (int j = 0; j < bent.h && testPassed; ++j) {
+        float x = 4.0f, y = 4.0f, z = 2.0f + j;
+        if (j > 8) {
+            x += 12.0f * (j - 8) / bend;
+            y += 6.0f * (j - 8) / bend;
+            z = 10.0f;
+        }
+        const unsigned char* row = bent.data + j * bent.w;
+        testPassed = std::abs(row[4] - (3.0f * x + 2.0f * y + 5.0f * z)) <= 1.0f;
+        for (int i = 0; i < 4; ++i) {
+            testPassed = testPassed && std::abs(row[i] + row[8 - i] - 2 * row[4]) <= 2;
+        }
+    }
+    delete[] bent.data;
+
+    auto [loaded, lazy] = loadedAndLazy();
+    std::vector<std::array<float, 3>> path = {{1.5f, 2.0f, 0.0f}, {5.0f, 6.5f, 1.0f}, {8.0f, 3.0f, 2.0f}};
+    Image fromLoaded = slicer.sliceCurved(loaded, path, 7, Slice::Spline, Slice::Trilinear, 0.5f);
+    Image fromLazy = slicer.sliceCurved(lazy, path, 7, Slice::Spline, Slice::Trilinear, 0.5f);
+    testPassed = testPassed && fromLoaded.h == fromLazy.h && std::equal(fromLoaded.data, fromLoaded.data + fromLoaded.w * fromLoaded.h, fromLazy.data);
+    delete[] fromLoaded.data;
+    delete[] fromLazy.data;
+
+    if (testPassed) {
+        std::cout << COL_GREEN << "[TEST] Curved slice test passed." << COL_NORMAL << std::endl << std::endl;
+    } else {
+        std::cerr << COL_RED << "[TEST] Curved slice test failed." << COL_NORMAL << std::endl << std::endl;
+    }
+}
+
+/**
+ * @brief Tests re-orienting a volume into XZ- and YZ-major order.
+ *
+ * Every voxel must land at its permuted position, and each slice of the result must equal the matching sliceXZ or sliceYZ view.
+ * The dimensions are chosen to leave partial 16 x 16 tiles along both axes, and a lazily loaded volume must give the same result
+ * as the loaded one.
+ */
+void testReorient() {
+    const int width = 53, height = 37, depth = 6;
+    Volume volume = randomVolume(width, height, depth, 11);
+    volume.spacing[0] = 1.0f;
+    volume.spacing[1] = 2.0f;
+    volume.spacing[2] = 3.0f;
+
+    Slice slicer;
+    Volume xz = slicer.reorient(volume, Slice::XZ);
+    Volume yz = slicer.reorient(volume, Slice::YZ);
+    bool testPassed = xz.w == width && xz.h == depth && xz.l == height && yz.w == height && yz.h == depth && yz.l == width;
+    testPassed = testPassed && xz.spacing[1] == 3.0f && xz.spacing[2] == 2.0f && yz.spacing[0] == 2.0f && yz.spacing[2] == 1.0f;
+    for (int z = 0; z < depth && testPassed; ++z) {
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                testPassed = testPassed && xz.at(x, z, y) == volume.at(x, y, z) && yz.at(y, z, x) == volume.at(x, y, z);
+            }
+        }
+    }
+    Volume view = volume;
+    slicer.sliceYZ(view, 20);
+    for (int z = 0; z < depth; ++z) {
+        testPassed = testPassed && std::equal(yz.row(z, 19), yz.row(z, 19) + height, view.slice.begin() + z * height);
+    }
+    slicer.sliceXZ(view, 30);
+    for (int z = 0; z < depth; ++z) {
+        testPassed = testPassed && std::equal(xz.row(z, 29), xz.row(z, 29) + width, view.slice.begin() + z * width);
+    }
+
+    auto [loaded, lazy] = loadedAndLazy();
+    for (Slice::Plane plane : {Slice::XZ, Slice::YZ}) {
+        Volume fromLoaded = slicer.reorient(loaded, plane);
+        Volume fromLazy = slicer.reorient(lazy, plane);
+        for (int z = 0; z < fromLoaded.l; ++z) {
+            for (int y = 0; y < fromLoaded.h; ++y) {
+                testPassed = testPassed && std::equal(fromLoaded.row(y, z), fromLoaded.row(y, z) + fromLoaded.w, fromLazy.row(y, z));
+            }
+        }
+    }
+
+    if (testPassed) {
+        std::cout << COL_GREEN << "[TEST] Reorient test passed." << COL_NORMAL << std::endl << std::endl;
+    } else {
+        std::cerr << COL_RED << "[TEST] Reorient test failed." << COL_NORMAL << std::endl << std::endl;
+    }
+}
+
+
+/**
+ * @brief Tests zero-copy views of volume slices and the 2D filters applied through them.
+ *
+ * The XY view of a volume whose rows are padded and its XZ view must show the same pixels as the slices, and blurring
+ * or thresholding a view must give the same pixels as filtering a copy of the slice as an Image, while writing the
+ * result straight into the volume and leaving every other slice alone. An XY view of a volume whose rows are not
+ * padded must be contiguous.
+ */
+void testSliceViews() {
+    Slice slicer;
+    bool testPassed = true;
+    for (int width : {37, 64}) {
+        const int height = 23, depth = 5;
+        Volume volume = randomVolume(width, height, depth, width);
+        ImageView xy = slicer.viewXY(volume, 3);
+        ImageView xz = slicer.viewXZ(volume, 8);
+        testPassed = testPassed && xy.contiguous() == (width == 64) && xy.w == width && xy.h == height && xz.w == width && xz.h == depth;
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                testPassed = testPassed && xy.row(y)[x] == volume.at(x, y, 2);
+            }
+        }
+        Volume copy = volume;
+        slicer.sliceXZ(copy, 8);
+        for (int z = 0; z < depth; ++z) {
+            testPassed = testPassed && std::equal(xz.row(z), xz.row(z) + width, copy.slice.begin() + z * width);
+        }
+
+        // filter a packed copy of each view as an Image, then the view itself, and compare
+        auto filterBoth = [&](ImageView view, const std::function<void(Image&)>& onImage, const std::function<void(ImageView&)>& onView) {
+            std::vector<unsigned char> pixels;
+            for (int y = 0; y < view.h; ++y) {
+                pixels.insert(pixels.end(), view.row(y), view.row(y) + view.w);
+            }
+            Image image;
+            image.w = view.w;
+            image.h = view.h;
+            image.c = 1;
+            image.data = pixels.data();
+            onImage(image);
+            onView(view);
+            for (int y = 0; y < view.h; ++y) {
+                testPassed = testPassed && view.c == 1 && std::equal(view.row(y), view.row(y) + view.w, pixels.begin() + y * view.w);
+            }
+            image.data = nullptr;
+        };
+        Blur blur;
+        ColourFilter colour;
+        EdgeDetection edges;
+        Volume before = volume;
+        filterBoth(slicer.viewXY(volume, 3), [&](Image& image) { blur.apply(Blur::Median, image, 3); }, [&](ImageView& view) { blur.apply(Blur::Median, view, 3); });
+        filterBoth(slicer.viewXY(volume, 3), [&](Image& image) { blur.apply(Blur::Box, image, 5); }, [&](ImageView& view) { blur.apply(Blur::Box, view, 5); });
+        filterBoth(slicer.viewXY(volume, 3), [&](Image& image) { blur.apply(Blur::Gaussian, image, 5, 1.5f); }, [&](ImageView& view) { blur.apply(Blur::Gaussian, view, 5, 1.5f); });
+        filterBoth(slicer.viewXY(volume, 3), [&](Image& image) { blur.apply(Blur::Gaussian, image, 0, 3.0f, Blur::Recursive); }, [&](ImageView& view) { blur.apply(Blur::Gaussian, view, 0, 3.0f, Blur::Recursive); });
+        filterBoth(slicer.viewXZ(volume, 8), [&](Image& image) { blur.apply(Blur::Box, image, 3); }, [&](ImageView& view) { blur.apply(Blur::Box, view, 3); });
+        filterBoth(slicer.viewXZ(volume, 8), [&](Image& image) { blur.apply(Blur::Gaussian, image, 3, 1.0f); }, [&](ImageView& view) { blur.apply(Blur::Gaussian, view, 3, 1.0f); });
+        filterBoth(slicer.viewXZ(volume, 8), [&](Image& image) { colour.apply(ColourFilter::thGREY, image, 128); }, [&](ImageView& view) { colour.apply(ColourFilter::thGREY, view, 128); });
+        filterBoth(slicer.viewXY(volume, 3), [&](Image& image) { edges.apply(image, EdgeDetection::Sobel); }, [&](ImageView& view) { edges.apply(view, EdgeDetection::Sobel); });
+        filterBoth(slicer.viewXZ(volume, 8), [&](Image& image) { edges.apply(image, EdgeDetection::RobertsCross); }, [&](ImageView& view) { edges.apply(view, EdgeDetection::RobertsCross); });
+        // filters that need RGB pixels must leave a single-channel view, and the slices around it, untouched
+        filterBoth(slicer.viewXY(volume, 3), [](Image&) {}, [&](ImageView& view) { colour.apply(ColourFilter::GrayScale, view); });
+        filterBoth(slicer.viewXY(volume, 3), [](Image&) {}, [&](ImageView& view) { colour.apply(ColourFilter::histHSL, view); });
+        for (int z = 0; z < depth; ++z) {
+            for (int y = 0; y < height; ++y) {
+                if (z != 2 && y != 7) {
+                    testPassed = testPassed && std::equal(volume.row(y, z), volume.row(y, z) + width, before.row(y, z));
+                }
+            }
+        }
+    }
+
+    if (testPassed) {
+        std::cout << COL_GREEN << "[TEST] Slice view test passed." << COL_NORMAL << std::endl << std::endl;
+    } else {
+        std::cerr << COL_RED << "[TEST] Slice view test failed." << COL_NORMAL << std::endl << std::endl;
+    }
+}
+
+
 #endif
\ No newline at end of file